@@ -13,6 +13,7 @@
 * - Check and checkmate detection
 * - Graphical interface
 * - Restart Functionality
+* - Resizable window, pieces rasterized from SVG at the exact tile size
 
 * Features that can and will be added Later:
 * - Choice to rotate the board after each turn
@@ -25,14 +26,45 @@
 #include<stdbool.h>
 #include<string.h>
 #include<math.h>
+#include<pthread.h>
+#include<stdint.h>
+#include<time.h>
+
+#ifdef __linux__
+#include<errno.h>
+#include<fcntl.h>
+#include<strings.h>
+#include<unistd.h>
+#include<arpa/inet.h>
+#include<netinet/in.h>
+#include<netinet/tcp.h>
+#include<sys/epoll.h>
+#include<sys/eventfd.h>
+#include<sys/resource.h>
+#include<sys/socket.h>
+#endif
 
 #include "raylib.h"
 
-#define TILE_SIZE 80
+#define TILE_SIZE 80            // initial tile size, the board follows the window afterwards
+#define MIN_TILE_SIZE 60
+#define SIDEBAR_WIDTH 240
 #define BOARD_SIZE 8
 #define BUFFER_SIZE 128
+#define PIECE_SCALE 0.85f
+#define WALL_MAX_BOARDS 64
+#define WALL_DEFAULT_BOARDS 16
+#define WALL_GAP 6
+#define WALL_MAX_PLIES 400      // safety net for games that shuffle without progress
+#define FIFTY_MOVE_PLIES 100
+#define GAME_OVER_DELAY 1.0
+#define HISTOGRAM_BUCKETS 34     // 1 ms buckets, the last one collects everything slower
+#define REPLAY_FPS 60.0          // virtual clock rate while recording or replaying
+#define REPLAY_SEED 12345u
+#define BROADCAST_DEFAULT_PORT 7777
+#define THREAD_LOCAL __thread
 #define MOVE_CIRCLE_RADIUS 10
-#define CAPTURE_CIRCLE_RADIUS (((TILE_SIZE) / 2) - 5)
+#define CAPTURE_CIRCLE_RADIUS (((tileSize) / 2) - 5)
 
 #define TILE_LIGHT GetColor(0xEEEED2FF)
 #define TILE_DARK  GetColor(0x769656FF)
@@ -80,372 +112,1656 @@ typedef struct Piece{
     bool enPassant;
 } Piece;
 
-Piece board[BOARD_SIZE][BOARD_SIZE];
+// The rules state is per thread, so headless analysis can run the rules in parallel.
+// The GUI only ever touches it from the main thread.
+THREAD_LOCAL Piece board[BOARD_SIZE][BOARD_SIZE];
 int selectedRow = -1;
 int selectedCol = -1;
-PieceColor turn = WHITE_PIECE;
-bool gameOver = false;
-bool promotionActive = false;
-int promotionRow = -1;
-int promotionCol = -1;
-PieceColor promotionColor = NONE_PIECE;
+THREAD_LOCAL PieceColor turn = WHITE_PIECE;
+THREAD_LOCAL bool gameOver = false;
+THREAD_LOCAL bool promotionActive = false;
+THREAD_LOCAL int promotionRow = -1;
+THREAD_LOCAL int promotionCol = -1;
+THREAD_LOCAL PieceColor promotionColor = NONE_PIECE;
 
 char gameResult[BUFFER_SIZE] = {0};
+double gameOverTime = 0;
 
 // en passant tracking
-int enPassantTargetRow = -1;
-int enPassantTargetCol = -1;
-PieceColor enPassantPawnColor = NONE_PIECE;
+THREAD_LOCAL int enPassantTargetRow = -1;
+THREAD_LOCAL int enPassantTargetCol = -1;
+THREAD_LOCAL PieceColor enPassantPawnColor = NONE_PIECE;
 
-// array to store Textures (I will be using pngs as piece models from the web)
-// Texture array[color][type];
-Texture2D pieceTextures[2][7];
+// current tile size in pixels, recomputed when the window is resized
+int tileSize = TILE_SIZE;
+
+// Piece atlas: every piece rasterized once at the current piece size
+// row = color (0 white, 1 black), column = PieceType, cells are atlasCellSize px square
+Texture2D pieceAtlas = {0};
+int atlasCellSize = 0;
+
+/**
+ * JobState enum: state of a background job (atlas rasterization, mate solving)
+ * Workers only fill in their result, the main thread consumes it and goes back to idle
+ */
+typedef enum JobState{
+    JOB_IDLE,
+    JOB_BUSY,
+    JOB_READY
+} JobState;
+
+pthread_t atlasThread;
+pthread_mutex_t atlasMutex = PTHREAD_MUTEX_INITIALIZER;
+JobState atlasState = JOB_IDLE;
+int atlasJobCellSize = 0;
+Image atlasJobImage = {0};
+int atlasGeneration = 0;    // bumped on every swap so cached renders know to redraw
+
+/**
+ * GameState struct: snapshot of everything the rules functions read or write
+ * The rules work on the globals above, so other games are swapped in and out
+ * with SaveGameState / LoadGameState
+ */
+typedef struct GameState{
+    Piece board[BOARD_SIZE][BOARD_SIZE];
+    PieceColor turn;
+    bool gameOver;
+    bool promotionActive;
+    int promotionRow;
+    int promotionCol;
+    PieceColor promotionColor;
+    int enPassantTargetRow;
+    int enPassantTargetCol;
+    PieceColor enPassantPawnColor;
+} GameState;
+
+/**
+ * WallBoard struct: one live game on the spectator wall
+ *
+ * bool dirty: changed since it was last drawn into wallCache
+ * checkRow/checkCol: king in check, -1 if none
+ * lastMove: source and destination of the last move, -1 if none
+ * plies: moves played since the reset
+ * quietPlies: moves since the last capture or pawn move (50-move rule)
+ */
+typedef struct WallBoard{
+    GameState game;
+    double nextMoveTime;
+    bool dirty;
+    int checkRow;
+    int checkCol;
+    int lastMove[4];
+    int plies;
+    int quietPlies;
+} WallBoard;
+
+// Spectator wall: grid of independent games drawn from one cached render texture
+WallBoard wallBoards[WALL_MAX_BOARDS];
+int wallCount = 0;
+int wallRequested = WALL_DEFAULT_BOARDS;
+bool wallActive = false;
+int wallCols = 0;
+int wallRows = 0;
+int wallTileSize = 0;
+RenderTexture2D wallCache = {0};
+int wallCacheGeneration = -1;
+
+/**
+ * InputEventType enum: semantic GUI input, stored independent of window size
+ */
+typedef enum InputEventType{
+    EVENT_CLICK,        // a = row, b = column
+    EVENT_PROMOTE,      // a = PieceType
+    EVENT_RESTART,
+    EVENT_WALL,         // spectator wall toggled (G)
+    EVENT_SOLVE,        // mate solve requested (M)
+    EVENT_END           // last recorded frame
+} InputEventType;
+
+/**
+ * InputEvent struct: one recorded input, replayed on the same frame number
+ * double time: seconds since start, informational (replay is frame driven)
+ */
+typedef struct InputEvent{
+    long frame;
+    double time;
+    InputEventType type;
+    int a;
+    int b;
+} InputEvent;
+
+const char* eventNames[] = { "CLICK", "PROMOTE", "RESTART", "WALL", "SOLVE", "END" };
+
+// Input record/replay (--record file, --replay file [--uncapped] [--histogram file])
+long inputFrame = 0;
+FILE* recordFile = NULL;
+InputEvent* replayEvents = NULL;
+int replayCount = 0;
+int replayNext = 0;
+bool replayActive = false;
+double* replayFrameMs = NULL;
+long replayFrameCount = 0;
+long replayFrameCapacity = 0;
+double replayLastFrameStart = 0;
+
+/*
+ * Instrumentation: per-frame zone timings and rules-engine call counters,
+ * shown as an overlay (F3) and optionally written to a CSV trace (F4 or
+ * --trace file). Built only with -DCHESS_PROFILE (Makefile PROFILING=TRUE,
+ * the default for DEBUG builds); otherwise every macro below expands to
+ * nothing and the instrumented code is exactly the uninstrumented code.
+ *
+ * Zone times are CPU submission time, raylib batches the actual GPU work.
+ */
+#ifdef CHESS_PROFILE
+
+#define PROFILE_HISTORY 120
+
+typedef enum ProfileZone{
+    ZONE_INPUT,
+    ZONE_BOARD,
+    ZONE_PIECES,
+    ZONE_SIDEBAR,
+    ZONE_WALL,
+    ZONE_COUNT
+} ProfileZone;
+
+typedef enum ProfileCounter{
+    COUNT_IS_VALID_MOVE,
+    COUNT_IS_IN_CHECK,
+    COUNT_TEST_MOVE_FOR_CHECK,
+    COUNTER_COUNT
+} ProfileCounter;
+
+/**
+ * ProfileFrame struct: everything measured during one frame
+ * workMs: frame start to just before EndDrawing, frameMs: full frame incl. vsync wait
+ */
+typedef struct ProfileFrame{
+    double zoneMs[ZONE_COUNT];
+    long counters[COUNTER_COUNT];
+    double workMs;
+    double frameMs;
+} ProfileFrame;
+
+void ProfileBeginFrame(void);
+void ProfileEndFrame(void);
+void ProfileAddZone(ProfileZone zone, double start);
+void ProfileStartTrace(const char* path);
+void ProfileShutdown(void);
+
+extern THREAD_LOCAL ProfileFrame profileCurrent;
+
+// Times the statement or block that follows it
+#define PROFILE_SCOPE(zone) \
+    for (double profileStart_ = GetTime(), profileOnce_ = 1; profileOnce_; \
+         profileOnce_ = 0, ProfileAddZone(zone, profileStart_))
+#define PROFILE_COUNT(counter) (profileCurrent.counters[counter]++)
+#define PROFILE_FRAME_BEGIN() ProfileBeginFrame()
+#define PROFILE_FRAME_END() ProfileEndFrame()
+#define PROFILE_SHUTDOWN() ProfileShutdown()
+
+#else
+
+#define PROFILE_SCOPE(zone)
+#define PROFILE_COUNT(counter)
+#define PROFILE_FRAME_BEGIN()
+#define PROFILE_FRAME_END()
+#define PROFILE_SHUTDOWN()
+
+#endif
 
 /*============= Core Game Functions =================*/
 void InitBoard(void);
 void LoadAssets(void);
 void UnloadAssets(void);
+void UpdateLayout(void);
+void UpdateAtlas(void);
+void DrawPieceSprite(PieceColor color, PieceType type, Rectangle dest);
 void DrawBoard(void);
 void DrawPieces(void);
+void DrawSidebar(void);
 void HandleInput(void);
+void HandleBoardClick(int row, int col);
+void ChoosePromotion(PieceType type);
+void RestartGame(void);
 void DrawPromotionMenu(void);
 
+/*============ SVG Rasterizer =======================*/
+Image RasterizeSvg(const char* svg, int size);
+
+/*============ Input Record / Replay ================*/
+bool StartRecording(const char* path);
+void RecordEvent(InputEventType type, int a, int b);
+void StopRecording(void);
+bool LoadReplay(const char* path);
+bool ReplayStep(void);
+void ReplayReport(const char* histogramPath);
+double InputClock(void);
+
+/*============ Spectator Broadcast ===================*/
+bool BroadcastStart(int port);
+void BroadcastSync(void);
+void BroadcastStop(void);
+int RunLoadTest(int viewers, int seconds, int port);
+
+/*============ Analysis / Annotation =================*/
+int RunAnnotator(const char* inPath, const char* outPath, long nodes, int moveTimeMs, int threads);
+
+/*============ Mate Solver ===========================*/
+int RunMateBatch(const char* path, int maxMoves, long nodeLimit, int hashMb);
+void RequestMateSolve(void);
+void UpdateMateSolve(void);
+void DrawMateHint(void);
+void DrawMateStatus(int x, int y);
+void StopMateSolve(void);
+
+/*============ Game State ============================*/
+void SaveGameState(GameState* g);
+void LoadGameState(const GameState* g);
+
+/*============ Spectator Wall ========================*/
+void InitWall(int count);
+void ToggleWall(void);
+void UpdateWallLayout(void);
+void StepWallGames(void);
+void RenderWallCache(void);
+void DrawWall(void);
+void UnloadWall(void);
+
 /*============ Move Validations ======================*/
 bool IsValidMove(int source_row, int source_column, int destination_row, int destination_column);
 bool MovePiece(int source_row, int source_column, int destination_row, int destination_column);
 bool IsInCheck(PieceColor color);
 bool HasAnyValidMove(PieceColor color);
+bool IsInsufficientMaterial(void);
 bool IsCheckmate(PieceColor color);
 bool IsPathClear(int source_row, int source_column, int destination_row, int destination_column);
 bool TestMoveForCheck(PieceColor color, int source_row, int source_column, int destination_row, int destination_column);
 void ResetEnPassant(void);
 
-int main(void) {
+int main(int argc, char* argv[]) {
+
+    const char* recordPath = NULL;
+    const char* histogramPath = NULL;
+    bool uncapped = false;
+    int servePort = 0;
+    const char* annotateIn = NULL;
+    const char* annotateOut = NULL;
+    long searchNodes = 0;
+    int searchMoveTime = 0;
+    int searchThreads = 0;     // 0 = one per core
+    const char* solvePath = NULL;
+    int mateMoves = 0;
+    int hashMb = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--wall") == 0) {
+            wallActive = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') wallRequested = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            if (!LoadReplay(argv[++i])) return 1;
+        }
+        else if (strcmp(argv[i], "--histogram") == 0 && i + 1 < argc) {
+            histogramPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--uncapped") == 0) {
+            uncapped = true;
+        }
+        else if (strcmp(argv[i], "--serve") == 0) {
+            servePort = BROADCAST_DEFAULT_PORT;
+            if (i + 1 < argc && argv[i + 1][0] != '-') servePort = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--loadtest") == 0) {
+            // headless: --loadtest [viewers] [seconds] [port]
+            int viewers = (i + 1 < argc) ? atoi(argv[i + 1]) : 1000;
+            int seconds = (i + 2 < argc) ? atoi(argv[i + 2]) : 10;
+            int port = (i + 3 < argc) ? atoi(argv[i + 3]) : BROADCAST_DEFAULT_PORT;
+            return RunLoadTest(viewers > 0 ? viewers : 1000, seconds > 0 ? seconds : 10, port);
+        }
+        else if (strcmp(argv[i], "--annotate") == 0 && i + 2 < argc) {
+            annotateIn = argv[++i];
+            annotateOut = argv[++i];
+        }
+        else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            searchNodes = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--movetime") == 0 && i + 1 < argc) {
+            searchMoveTime = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            searchThreads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--solve") == 0 && i + 1 < argc) {
+            solvePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--mate") == 0 && i + 1 < argc) {
+            mateMoves = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+            hashMb = atoi(argv[++i]);
+        }
+#ifdef CHESS_PROFILE
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            ProfileStartTrace(argv[++i]);
+        }
+#endif
+    }
+
+    // headless tools, no window
+    if (annotateIn != NULL) return RunAnnotator(annotateIn, annotateOut, searchNodes, searchMoveTime, searchThreads);
+    if (solvePath != NULL) return RunMateBatch(solvePath, mateMoves, searchNodes, hashMb);
 
-    InitWindow(BOARD_SIZE * TILE_SIZE + 240, BOARD_SIZE * TILE_SIZE, 
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+    InitWindow(BOARD_SIZE * TILE_SIZE + SIDEBAR_WIDTH, BOARD_SIZE * TILE_SIZE, 
                "Chess - Faseeh Ur Rehman");
-    SetTargetFPS(60);
+    SetWindowMinSize(BOARD_SIZE * MIN_TILE_SIZE + SIDEBAR_WIDTH, BOARD_SIZE * MIN_TILE_SIZE);
+    SetTargetFPS(uncapped ? 0 : 60);
 
     LoadAssets();
     InitBoard();
 
-    while (!WindowShouldClose()) {
-
-        HandleInput();
-        BeginDrawing();
-        ClearBackground(GetColor(0x181818FF));
-        DrawBoard();
-        DrawPieces();
-        DrawPromotionMenu();
-
-        int sideX = BOARD_SIZE * TILE_SIZE;
+    if (recordPath != NULL && !replayActive) StartRecording(recordPath);
+    if (servePort != 0) BroadcastStart(servePort);
 
-        DrawRectangle(sideX, 0, 240, BOARD_SIZE * TILE_SIZE, GetColor(0x252525FF));
-        DrawRectangle(sideX, 0, 5, BOARD_SIZE * TILE_SIZE, GetColor(0x333333FF));
-
-        DrawText("PROJECT CHESS", sideX + 30, 30, 22, GetColor(0x69923EFF));
-        DrawRectangle(sideX + 40, 60, 140, 2, DARKGRAY);
-
-
-        DrawText("CURRENT MOVE", sideX + 30, 100, 14, LIGHTGRAY);
-
-        Color cardColor = (turn == WHITE_PIECE) ? RAYWHITE : GetColor(0x383838FF);
-        Color textColor = (turn == WHITE_PIECE) ? BLACK : RAYWHITE;
-
-        DrawRectangleRounded((Rectangle){sideX + 25, 125, 190, 80}, 0.2, 10, 
-                           Fade(BLACK, 0.3f));
-        DrawRectangleRounded((Rectangle){sideX + 20, 120, 190, 80}, 0.2, 10, cardColor);
+    if (wallActive) {
+        wallActive = false;
+        ToggleWall();
+    }
 
-        const char* turnText = (turn == WHITE_PIECE) ? "WHITE" : "BLACK";
-        int tw = MeasureText(turnText, 28);
-        DrawText(turnText, sideX + 20 + (190 - tw) / 2, 145, 28, textColor);
+    while (!WindowShouldClose()) {
 
+        inputFrame++;
+        if (replayActive && !ReplayStep()) break;
 
-        if (IsInCheck(turn)) {
+        PROFILE_FRAME_BEGIN();
 
-            float pulse = (sinf(GetTime() * 10.0f) * 0.5f) + 0.5f;
-            DrawRectangleRounded((Rectangle){sideX + 50, 215, 130, 30}, 0.5, 10, Fade(RED, 0.2f + (pulse * 0.3f)));
-            DrawText("KING IN CHECK", sideX + 65, 224, 12, RED);
+        if (IsWindowResized()) {
+            UpdateLayout();
+            if (wallActive) UpdateWallLayout();
         }
+        if (!replayActive && IsKeyPressed(KEY_G)) {
+            RecordEvent(EVENT_WALL, 0, 0);
+            ToggleWall();
+        }
+        UpdateAtlas();
 
-        if (gameOver) {
-            DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(), Fade(BLACK, 0.6f));
-
-            _sleep(1000);
-
-            Rectangle resBox = { sideX - 450, 200, 400, 200 };
-            DrawRectangleRounded(resBox, 0.1, 10, GetColor(0x202020FF));
-            DrawRectangleRoundedLines(resBox, 0.1, 10, TILE_DARK);
+        if (wallActive) {
+            PROFILE_SCOPE(ZONE_WALL) {
+                StepWallGames();
+                RenderWallCache();
+            }
 
-            DrawText("GAME OVER", resBox.x + 110, resBox.y + 30, 30, TILE_DARK);
+            BeginDrawing();
+            ClearBackground(GetColor(0x181818FF));
+            DrawWall();
+            PROFILE_FRAME_END();
+            EndDrawing();
+            continue;
+        }
 
-            int resW = MeasureText(gameResult, 20);
-            DrawText(gameResult, resBox.x + (400 - resW) / 2, resBox.y + 80, 20, RAYWHITE);
+        if (!replayActive && IsKeyPressed(KEY_M)) {
+            RecordEvent(EVENT_SOLVE, 0, 0);
+            RequestMateSolve();
+        }
+        UpdateMateSolve();
 
-            Rectangle btn = { resBox.x + 100, resBox.y + 130, 200, 45 };
-            bool hover = CheckCollisionPointRec(GetMousePosition(), btn);
-            DrawRectangleRounded(btn, 0.2, 10, hover ? TILE_DARK : DARKGRAY);
-            DrawText("PLAY AGAIN", btn.x + 45, btn.y + 12, 18, hover ? BLACK : RAYWHITE);
+        PROFILE_SCOPE(ZONE_INPUT) HandleInput();
+        BeginDrawing();
+        ClearBackground(GetColor(0x181818FF));
+        PROFILE_SCOPE(ZONE_BOARD) DrawBoard();
+        PROFILE_SCOPE(ZONE_PIECES) DrawPieces();
+        DrawPromotionMenu();
 
-            if (hover && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                InitBoard();
-                turn = WHITE_PIECE;
-                gameOver = false;
-                selectedRow = -1;
-                ResetEnPassant();
-            }
-        } else {
-            DrawText("L-Click: Select/Move", sideX + 35, BOARD_SIZE * TILE_SIZE - 60, 14, WHITE);
-            DrawText("R-Click: Deselect", sideX + 45, BOARD_SIZE * TILE_SIZE - 40, 14, WHITE);
-        }
+        PROFILE_SCOPE(ZONE_SIDEBAR) DrawSidebar();
 
+        PROFILE_FRAME_END();
         EndDrawing();
     }
 
+    if (replayActive) ReplayReport(histogramPath);
+    StopRecording();
+    BroadcastStop();
+
+    StopMateSolve();
+    PROFILE_SHUTDOWN();
+    UnloadWall();
     UnloadAssets();
     CloseWindow();
     return 0;
 }
 
 //===========================================================================
-// ASSET MANAGEMENT FUNCTIONS
+// SVG RASTERIZER
 //===========================================================================
 
+/*
+ * Minimal SVG rasterizer for the piece set in assets/SVG, so pieces are
+ * drawn at the exact pixel size without depending on how raylib was built.
+ * Supports <svg viewBox>, nested <g>, <path> (M L H V C S Q A Z, absolute
+ * and relative), <circle>, <line> and <rect>; fill, stroke, stroke-width,
+ * stroke-linecap and stroke-linejoin with #RGB / #RRGGBB / none colors.
+ * Shapes are flattened to edges in pixel space and filled with the nonzero
+ * rule on SVG_SUBSAMPLES sub-scanlines per row, with exact horizontal
+ * coverage. Strokes are built as a union of positively wound polygons
+ * (segment quads, joins, caps) and filled the same way.
+ *
+ * CPU only, safe to call from the atlas worker.
+ */
+
+#define SVG_SUBSAMPLES 5
+#define SVG_MAX_DEPTH 16
+#define SVG_MITER_LIMIT 4.0f
+
+typedef enum SvgLineCap{ SVG_CAP_BUTT, SVG_CAP_ROUND, SVG_CAP_SQUARE } SvgLineCap;
+typedef enum SvgLineJoin{ SVG_JOIN_MITER, SVG_JOIN_ROUND, SVG_JOIN_BEVEL } SvgLineJoin;
+
 /**
- * @brief Loads all piece textures from /assets/PNG
- * File Path follow pattern: assets/PNG/{color}_{piece}.png
+ * SvgStyle struct: presentation attributes, inherited through <g>
  */
-void LoadAssets(){
-    const char* names[] = { "", "pawn", "rook", "knight", "bishop", "queen", "king" };
-    char path[128];
+typedef struct SvgStyle{
+    bool hasFill;
+    Color fill;
+    bool hasStroke;
+    Color stroke;
+    float strokeWidth;
+    SvgLineCap cap;
+    SvgLineJoin join;
+} SvgStyle;
+
+/**
+ * SvgEdge struct: one non-horizontal edge, y0 < y1, dir is +1 downwards, -1 upwards
+ */
+typedef struct SvgEdge{
+    float x0, y0, x1, y1;
+    int dir;
+} SvgEdge;
 
-    for (int i = 1; i <= 6; i++) {
-        // White pieces
-        sprintf(path, "assets/PNG/white_%s.png", names[i]);
-        pieceTextures[0][i] = LoadTexture(path);
+typedef struct SvgShape{
+    SvgEdge* edges;
+    int count;
+    int capacity;
+} SvgShape;
 
-        // Black pieces
-        sprintf(path, "assets/PNG/black_%s.png", names[i]);
-        pieceTextures[1][i] = LoadTexture(path);
-    }
-}
+/**
+ * SvgPath struct: flattened geometry in pixels
+ * subpath i is pts[subStart[i] .. subStart[i] + subCount[i])
+ */
+typedef struct SvgPath{
+    Vector2* pts;
+    int count;
+    int capacity;
+    int* subStart;
+    int* subCount;
+    bool* subClosed;
+    int subs;
+    int subCapacity;
+} SvgPath;
 
 /**
- * @brief Releases all Loaded Textures.
- * Unloads texture from pieceTexture 2D array
+ * SvgCanvas struct: premultiplied float RGBA target plus the user-to-pixel mapping
  */
-void UnloadAssets() {
-    for (int i = 1; i <= 6; i++) {
-        UnloadTexture(pieceTextures[0][i]);
-        UnloadTexture(pieceTextures[1][i]);
+typedef struct SvgCanvas{
+    float* rgba;
+    int size;
+    float scale;
+    float originX;
+    float originY;
+} SvgCanvas;
+
+void SvgAddEdge(SvgShape* sh, Vector2 a, Vector2 b) {
+    if (a.y == b.y) return;
+
+    if (sh->count == sh->capacity) {
+        sh->capacity = (sh->capacity == 0) ? 256 : sh->capacity * 2;
+        sh->edges = realloc(sh->edges, sizeof(SvgEdge) * sh->capacity);
     }
-}
 
-//===========================================================================
-// BOARD INITIALIZATION FUNCTION
-//===========================================================================
+    if (a.y < b.y) sh->edges[sh->count++] = (SvgEdge){ a.x, a.y, b.x, b.y, 1 };
+    else sh->edges[sh->count++] = (SvgEdge){ b.x, b.y, a.x, a.y, -1 };
+}
 
 /**
- * @brief Set Up Standard chess Sarting position
- *
- * Chess Board Setup:
- *  0 | r n b q k b n r
- *  1 | p p p p p p p p
- *  2 |
- *  3 |
- *  4 |
- *  5 |
- *  6 | P P P P P P P P
- *  7 | R N B Q K B N R
- */                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                      
-void InitBoard() {
-    memset(board, 0, sizeof(board));
-
-    board[0][0] = (Piece){ROOK, BLACK_PIECE, false, false};
-    board[0][1] = (Piece){KNIGHT, BLACK_PIECE, false, false};
-    board[0][3] = (Piece){QUEEN, BLACK_PIECE, false, false};
-    board[0][2] = (Piece){BISHOP, BLACK_PIECE, false, false};
-    board[0][4] = (Piece){KING, BLACK_PIECE, false, false};
-    board[0][5] = (Piece){BISHOP, BLACK_PIECE, false, false};
-    board[0][6] = (Piece){KNIGHT, BLACK_PIECE, false, false};
-    board[0][7] = (Piece){ROOK, BLACK_PIECE, false, false};
+ * @brief Adds a closed polygon
+ * positive: rewind it clockwise first, so overlapping stroke pieces add up
+ * under the nonzero rule instead of cancelling
+ */
+void SvgAddPolygon(SvgShape* sh, const Vector2* p, int n, bool positive) {
+    if (n < 3) return;
+
+    bool reverse = false;
+    if (positive) {
+        float area = 0;
+        for (int i = 0; i < n; i++) {
+            Vector2 a = p[i], b = p[(i + 1) % n];
+            area += a.x * b.y - b.x * a.y;
+        }
+        reverse = area < 0;
+    }
 
-    for (int c = 0; c < 8; c++) 
-        board[1][c] = (Piece){PAWN, BLACK_PIECE, false, false};
+    for (int i = 0; i < n; i++) {
+        Vector2 a = p[i], b = p[(i + 1) % n];
+        if (reverse) SvgAddEdge(sh, b, a);
+        else SvgAddEdge(sh, a, b);
+    }
+}
 
-    for (int c = 0; c < 8; c++) 
-        board[6][c] = (Piece){PAWN, WHITE_PIECE, false, false};
+void SvgAddCircle(SvgShape* sh, Vector2 c, float r, bool positive) {
+    Vector2 pts[128];
+    int n = (int)(r * 2.0f);
+    if (n < 12) n = 12;
+    if (n > 128) n = 128;
 
-    board[7][0] = (Piece){ROOK, WHITE_PIECE, false, false};
-    board[7][1] = (Piece){KNIGHT, WHITE_PIECE, false, false};
-    board[7][2] = (Piece){BISHOP, WHITE_PIECE, false, false};
-    board[7][3] = (Piece){QUEEN, WHITE_PIECE, false, false};
-    board[7][4] = (Piece){KING, WHITE_PIECE, false, false};
-    board[7][5] = (Piece){BISHOP, WHITE_PIECE, false, false};
-    board[7][6] = (Piece){KNIGHT, WHITE_PIECE, false, false};
-    board[7][7] = (Piece){ROOK, WHITE_PIECE, false, false};
+    for (int i = 0; i < n; i++) {
+        float t = 2.0f * PI * i / n;
+        pts[i] = (Vector2){ c.x + r * cosf(t), c.y + r * sinf(t) };
+    }
+    SvgAddPolygon(sh, pts, n, positive);
+}
 
-    for(int r = 2; r < 6; r++)
-        for(int c = 0; c < 8; c++)
-            board[r][c] = (Piece){EMPTY, NONE_PIECE, false, false};
+void SvgAddQuad(SvgShape* sh, Vector2 a, Vector2 b, Vector2 c, Vector2 d) {
+    Vector2 q[4] = { a, b, c, d };
+    SvgAddPolygon(sh, q, 4, true);
+}
 
-    ResetEnPassant();
+int SvgCompareEdges(const void* a, const void* b) {
+    float ya = ((const SvgEdge*)a)->y0, yb = ((const SvgEdge*)b)->y0;
+    return (ya > yb) - (ya < yb);
 }
 
-//===========================================================================
-// RENDERING FUNCTIONS
-//===========================================================================
+void SvgAddSpan(float* cov, int size, float xa, float xb, float w) {
+    if (xa < 0) xa = 0;
+    if (xb > size) xb = (float)size;
+    if (xb <= xa) return;
+
+    int ia = (int)xa, ib = (int)xb;
+    if (ia == ib) {
+        cov[ia] += (xb - xa) * w;
+        return;
+    }
+    cov[ia] += (ia + 1 - xa) * w;
+    for (int i = ia + 1; i < ib; i++) cov[i] += w;
+    if (ib < size) cov[ib] += (xb - ib) * w;
+}
 
 /**
- * @brief Renders the Chess Board with selection Highlights
- * Renders 64 squares with alternating colors and visual feedback for:
- * - Selected Square (Yellow Highlights)
- * - Valid Moves (circles for empty squares, rings for captures)
+ * @brief Fills a shape with the nonzero rule and blends it over the canvas
  */
-void DrawBoard() {
-    for(int r = 0; r < BOARD_SIZE; r++) {
-        for(int c = 0; c < BOARD_SIZE; c++) {
-            Color sq = ((r + c) % 2 == 0) ? TILE_LIGHT : TILE_DARK;
-            DrawRectangle(c * TILE_SIZE, r * TILE_SIZE, TILE_SIZE, TILE_SIZE, sq);
+void SvgFillShape(SvgCanvas* cv, SvgShape* sh, Color color) {
+    if (sh->count == 0) return;
 
-            if (selectedRow != -1 && IsValidMove(selectedRow, selectedCol, r, c)) {
-                if (!TestMoveForCheck(board[selectedRow][selectedCol].color, selectedRow, selectedCol, r, c)){
-                    if(board[r][c].type == EMPTY) {
-                        DrawCircle(c * TILE_SIZE + TILE_SIZE/2, r * TILE_SIZE + TILE_SIZE/2, 10, MOVE_CIRCLE_COLOR);
-                    }else{
-                        DrawCircleLines(c * TILE_SIZE + TILE_SIZE/2, r * TILE_SIZE + TILE_SIZE/2, TILE_SIZE/2 - 5, MOVE_CIRCLE_COLOR);
-                    }
+    int size = cv->size;
+    qsort(sh->edges, sh->count, sizeof(SvgEdge), SvgCompareEdges);
+
+    float* cov = malloc(sizeof(float) * (size + 1));
+    int* active = malloc(sizeof(int) * sh->count);
+    float* xs = malloc(sizeof(float) * sh->count);
+    int* dirs = malloc(sizeof(int) * sh->count);
+    int activeCount = 0, next = 0;
+
+    float a = color.a / 255.0f;
+    float r = color.r / 255.0f * a, g = color.g / 255.0f * a, b = color.b / 255.0f * a;
+
+    for (int py = 0; py < size; py++) {
+        memset(cov, 0, sizeof(float) * (size + 1));
+        bool any = false;
+
+        for (int s = 0; s < SVG_SUBSAMPLES; s++) {
+            float y = py + (s + 0.5f) / SVG_SUBSAMPLES;
+
+            while (next < sh->count && sh->edges[next].y0 <= y) active[activeCount++] = next++;
+
+            // collect crossings, dropping edges that ended above this line
+            int n = 0;
+            for (int i = 0; i < activeCount; ) {
+                SvgEdge* e = &sh->edges[active[i]];
+                if (e->y1 <= y) {
+                    active[i] = active[--activeCount];
+                    continue;
+                }
+                float x = e->x0 + (y - e->y0) * (e->x1 - e->x0) / (e->y1 - e->y0);
+
+                int j = n++;
+                while (j > 0 && xs[j - 1] > x) {
+                    xs[j] = xs[j - 1];
+                    dirs[j] = dirs[j - 1];
+                    j--;
                 }
+                xs[j] = x;
+                dirs[j] = e->dir;
+                i++;
             }
 
-            if (r == selectedRow && c == selectedCol) {
-                DrawRectangle(c * TILE_SIZE, r * TILE_SIZE, TILE_SIZE, TILE_SIZE, Fade(YELLOW, 0.4f));
+            int winding = 0;
+            float spanStart = 0;
+            for (int i = 0; i < n; i++) {
+                if (winding == 0) spanStart = xs[i];
+                winding += dirs[i];
+                if (winding == 0) {
+                    SvgAddSpan(cov, size, spanStart, xs[i], 1.0f / SVG_SUBSAMPLES);
+                    any = true;
+                }
             }
         }
+        if (!any) continue;
+
+        float* row = cv->rgba + (size_t)py * size * 4;
+        for (int x = 0; x < size; x++) {
+            float c = (cov[x] > 1.0f) ? 1.0f : cov[x];
+            if (c <= 0) continue;
+
+            float inv = 1.0f - a * c;
+            row[x * 4 + 0] = r * c + row[x * 4 + 0] * inv;
+            row[x * 4 + 1] = g * c + row[x * 4 + 1] * inv;
+            row[x * 4 + 2] = b * c + row[x * 4 + 2] * inv;
+            row[x * 4 + 3] = a * c + row[x * 4 + 3] * inv;
+        }
     }
+
+    free(cov);
+    free(active);
+    free(xs);
+    free(dirs);
 }
 
-/**
- * @brief Render all pieces on the board
- * Incudes special highlighting for kings in Check
- */
-void DrawPieces() {
-    bool wCheck = IsInCheck(WHITE_PIECE);
-    bool bCheck = IsInCheck(BLACK_PIECE);
+void SvgPathBegin(SvgPath* path) {
+    if (path->subs > 0 && path->subCount[path->subs - 1] == 0) return;
 
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            Piece p = board[r][c];
-            if (p.type == EMPTY) continue;
-            if (p.type == KING) {
-                if ((p.color == WHITE_PIECE && wCheck) || (p.color == BLACK_PIECE && bCheck)){
-                    DrawRectangle(c * TILE_SIZE, r * TILE_SIZE, TILE_SIZE, TILE_SIZE, CHECK_COLOR);
-                }
-            }
+    if (path->subs == path->subCapacity) {
+        path->subCapacity = (path->subCapacity == 0) ? 16 : path->subCapacity * 2;
+        path->subStart = realloc(path->subStart, sizeof(int) * path->subCapacity);
+        path->subCount = realloc(path->subCount, sizeof(int) * path->subCapacity);
+        path->subClosed = realloc(path->subClosed, sizeof(bool) * path->subCapacity);
+    }
+    path->subStart[path->subs] = path->count;
+    path->subCount[path->subs] = 0;
+    path->subClosed[path->subs] = false;
+    path->subs++;
+}
 
-            int colorIdx = (p.color == WHITE_PIECE) ? 0 : 1;
-            Texture2D tex = pieceTextures[colorIdx][p.type];
+void SvgPathPoint(SvgPath* path, const SvgCanvas* cv, float x, float y) {
+    if (path->subs == 0) SvgPathBegin(path);
+    if (path->count == path->capacity) {
+        path->capacity = (path->capacity == 0) ? 256 : path->capacity * 2;
+        path->pts = realloc(path->pts, sizeof(Vector2) * path->capacity);
+    }
+    path->pts[path->count++] = (Vector2){ (x - cv->originX) * cv->scale, (y - cv->originY) * cv->scale };
+    path->subCount[path->subs - 1]++;
+}
 
-            float scale = (float)TILE_SIZE / (float)tex.width * 0.85f;
+void SvgFreePath(SvgPath* path) {
+    free(path->pts);
+    free(path->subStart);
+    free(path->subCount);
+    free(path->subClosed);
+    memset(path, 0, sizeof(*path));
+}
 
-            Vector2 pos = {
-                c * TILE_SIZE + (TILE_SIZE - tex.width * scale) / 2,
-                r * TILE_SIZE + (TILE_SIZE - tex.height * scale) / 2
-            };
+void SvgCubic(SvgPath* path, const SvgCanvas* cv, Vector2 p0, Vector2 c1, Vector2 c2, Vector2 p3) {
+    float len = hypotf(c1.x - p0.x, c1.y - p0.y) + hypotf(c2.x - c1.x, c2.y - c1.y) + hypotf(p3.x - c2.x, p3.y - c2.y);
+    int n = (int)(len * cv->scale / 2.0f);
+    if (n < 4) n = 4;
+    if (n > 100) n = 100;
+
+    for (int i = 1; i <= n; i++) {
+        float t = (float)i / n, u = 1.0f - t;
+        float b0 = u * u * u, b1 = 3 * u * u * t, b2 = 3 * u * t * t, b3 = t * t * t;
+        SvgPathPoint(path, cv, b0 * p0.x + b1 * c1.x + b2 * c2.x + b3 * p3.x,
+                               b0 * p0.y + b1 * c1.y + b2 * c2.y + b3 * p3.y);
+    }
+}
 
-            DrawTextureEx(tex, pos, 0, scale, WHITE);
-        }
+/**
+ * @brief Elliptical arc from p0 to p1, endpoint to center conversion per SVG 1.1 F.6.5
+ */
+void SvgArc(SvgPath* path, const SvgCanvas* cv, Vector2 p0, float rx, float ry, float rotation,
+            bool largeArc, bool sweep, Vector2 p1) {
+    rx = fabsf(rx);
+    ry = fabsf(ry);
+    if (rx == 0 || ry == 0 || (p0.x == p1.x && p0.y == p1.y)) {
+        SvgPathPoint(path, cv, p1.x, p1.y);
+        return;
+    }
+
+    float phi = rotation * PI / 180.0f, cs = cosf(phi), sn = sinf(phi);
+    float dx = (p0.x - p1.x) / 2, dy = (p0.y - p1.y) / 2;
+    float x1 = cs * dx + sn * dy, y1 = -sn * dx + cs * dy;
+
+    float lambda = (x1 * x1) / (rx * rx) + (y1 * y1) / (ry * ry);
+    if (lambda > 1) {
+        rx *= sqrtf(lambda);
+        ry *= sqrtf(lambda);
+    }
+
+    float num = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+    float den = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+    float coef = (num > 0 && den > 0) ? sqrtf(num / den) : 0;
+    if (largeArc == sweep) coef = -coef;
+
+    float cxp = coef * rx * y1 / ry, cyp = -coef * ry * x1 / rx;
+    float cx = cs * cxp - sn * cyp + (p0.x + p1.x) / 2;
+    float cy = sn * cxp + cs * cyp + (p0.y + p1.y) / 2;
+
+    float ux = (x1 - cxp) / rx, uy = (y1 - cyp) / ry;
+    float vx = (-x1 - cxp) / rx, vy = (-y1 - cyp) / ry;
+    float theta = atan2f(uy, ux);
+    float delta = atan2f(ux * vy - uy * vx, ux * vx + uy * vy);
+    if (!sweep && delta > 0) delta -= 2 * PI;
+    if (sweep && delta < 0) delta += 2 * PI;
+
+    int n = (int)(fabsf(delta) * fmaxf(rx, ry) * cv->scale / 2.0f);
+    if (n < 4) n = 4;
+    if (n > 100) n = 100;
+
+    for (int i = 1; i <= n; i++) {
+        float t = theta + delta * i / n;
+        float ex = rx * cosf(t), ey = ry * sinf(t);
+        SvgPathPoint(path, cv, cx + ex * cs - ey * sn, cy + ex * sn + ey * cs);
     }
 }
 
-//===========================================================================
-// INPUT HANDLING FUNCTION
-//===========================================================================
+float SvgNumber(const char** p) {
+    while (**p == ' ' || **p == ',' || **p == '\t' || **p == '\n' || **p == '\r') (*p)++;
+    char* end;
+    float v = strtof(*p, &end);
+    *p = end;
+    return v;
+}
 
 /**
- * @brief Process mouse input for piece selection and movement
- * Implements two-step interaction: select piece -> select destination
+ * @brief Flattens path data into subpaths of pixel coordinates
  */
-void HandleInput() {
-    if(promotionActive) return;
-    if (gameOver) return;
+void SvgParsePathData(SvgPath* path, const SvgCanvas* cv, const char* d) {
+    const char* p = d;
+    char cmd = 0;
+    Vector2 cur = {0}, start = {0}, ctrl = {0};
+    char prev = 0;
+    bool pendingStart = false;
+
+    for (;;) {
+        while (*p == ' ' || *p == ',' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+        if (*p == '\0') break;
+
+        if (strchr("MmLlHhVvCcSsQqAaZz", *p) != NULL && *p != '\0') {
+            cmd = *p++;
+        } else if (cmd == 0 || strchr("0123456789+-.", *p) == NULL) {
+            break;
+        }
 
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-        int col = GetMouseX() / TILE_SIZE;
-        int row = GetMouseY() / TILE_SIZE;
+        bool rel = cmd >= 'a';
+        Vector2 base = rel ? cur : (Vector2){0};
+        char upper = rel ? cmd - 32 : cmd;
+        const char* before = p;
 
-        if (col >= 8 || row >= 8) {
-            selectedRow = -1;
-            return;
+        // drawing on after Z starts a new subpath at the closing point
+        if (pendingStart && upper != 'M' && upper != 'Z') {
+            SvgPathBegin(path);
+            SvgPathPoint(path, cv, start.x, start.y);
         }
-
-        if(selectedRow == -1){
-            if (board[row][col].color == turn) {
-                selectedRow = row;
-                selectedCol = col;
-            }
-        }else{
-            if (board[row][col].color == turn) {
-                selectedRow = row;
-                selectedCol = col;
-            } else if (MovePiece(selectedRow, selectedCol, row, col)) {
-                    turn = (turn == WHITE_PIECE) ? BLACK_PIECE : WHITE_PIECE;
-                if (IsCheckmate(turn)) {
-                    gameOver = true;
-                    sprintf(gameResult, "Checkmate! %s Wins", (turn == BLACK_PIECE ? "White" : "Black"));
-                } else if (!HasAnyValidMove(turn)){
-                    gameOver = true;
-                    strcpy(gameResult, "Stalemate! Draw");
+        pendingStart = false;
+
+        switch (upper) {
+            case 'M': {
+                float x = SvgNumber(&p), y = SvgNumber(&p);
+                cur = start = (Vector2){ base.x + x, base.y + y };
+                SvgPathBegin(path);
+                SvgPathPoint(path, cv, cur.x, cur.y);
+                cmd = rel ? 'l' : 'L';
+            } break;
+            case 'L': {
+                float x = SvgNumber(&p), y = SvgNumber(&p);
+                cur = (Vector2){ base.x + x, base.y + y };
+                SvgPathPoint(path, cv, cur.x, cur.y);
+            } break;
+            case 'H': {
+                cur.x = base.x + SvgNumber(&p);
+                SvgPathPoint(path, cv, cur.x, cur.y);
+            } break;
+            case 'V': {
+                cur.y = base.y + SvgNumber(&p);
+                SvgPathPoint(path, cv, cur.x, cur.y);
+            } break;
+            case 'C':
+            case 'S': {
+                Vector2 c1;
+                if (upper == 'C') {
+                    c1.x = base.x + SvgNumber(&p);
+                    c1.y = base.y + SvgNumber(&p);
+                } else {
+                    bool smooth = prev == 'C' || prev == 'S';
+                    c1 = smooth ? (Vector2){ 2 * cur.x - ctrl.x, 2 * cur.y - ctrl.y } : cur;
                 }
-                selectedRow = -1;
-            } else {
-                selectedRow = -1;
-            }
+                Vector2 c2 = { base.x + SvgNumber(&p), 0 };
+                c2.y = base.y + SvgNumber(&p);
+                Vector2 end = { base.x + SvgNumber(&p), 0 };
+                end.y = base.y + SvgNumber(&p);
+                SvgCubic(path, cv, cur, c1, c2, end);
+                ctrl = c2;
+                cur = end;
+            } break;
+            case 'Q': {
+                Vector2 q = { base.x + SvgNumber(&p), 0 };
+                q.y = base.y + SvgNumber(&p);
+                Vector2 end = { base.x + SvgNumber(&p), 0 };
+                end.y = base.y + SvgNumber(&p);
+                Vector2 c1 = { cur.x + 2.0f / 3 * (q.x - cur.x), cur.y + 2.0f / 3 * (q.y - cur.y) };
+                Vector2 c2 = { end.x + 2.0f / 3 * (q.x - end.x), end.y + 2.0f / 3 * (q.y - end.y) };
+                SvgCubic(path, cv, cur, c1, c2, end);
+                cur = end;
+            } break;
+            case 'A': {
+                float rx = SvgNumber(&p), ry = SvgNumber(&p), rot = SvgNumber(&p);
+                bool large = SvgNumber(&p) != 0, sweep = SvgNumber(&p) != 0;
+                Vector2 end = { base.x + SvgNumber(&p), 0 };
+                end.y = base.y + SvgNumber(&p);
+                SvgArc(path, cv, cur, rx, ry, rot, large, sweep, end);
+                cur = end;
+            } break;
+            case 'Z': {
+                if (path->subs > 0) path->subClosed[path->subs - 1] = true;
+                cur = start;
+                pendingStart = true;
+            } break;
         }
+        prev = upper;
+
+        if (upper != 'Z' && p == before) break;    // malformed numbers, stop instead of looping
     }
 }
 
-//===========================================================================
-// MOVE VALIDATION FUNCTIONS
-//===========================================================================
-
 /**
- * @brief Validates move according to chess piece rules (FIDE rules)
- * Performs basic validation without considering King Safety
- *
- * @param sr Source Row
- * @param sc Source Column
- * @param dr Destination Row
- * @param dc Destination Column
- *
- * @return true if move follows piece movement rules
+ * @brief Outlines one polyline as positively wound quads, joins and caps
  */
-bool IsValidMove(int sr, int sc, int dr, int dc) {
+void SvgStrokePolyline(SvgShape* sh, const Vector2* src, int srcCount, bool closed, float hw, SvgLineCap cap, SvgLineJoin join) {
+    Vector2* p = malloc(sizeof(Vector2) * (srcCount + 1));
+    int n = 0;
+    for (int i = 0; i < srcCount; i++)
+        if (n == 0 || fabsf(src[i].x - p[n - 1].x) + fabsf(src[i].y - p[n - 1].y) > 1e-4f) p[n++] = src[i];
+    if (closed && n > 1 && fabsf(p[0].x - p[n - 1].x) + fabsf(p[0].y - p[n - 1].y) <= 1e-4f) n--;
+
+    if (n == 1) {
+        if (cap == SVG_CAP_ROUND) SvgAddCircle(sh, p[0], hw, true);
+        if (cap == SVG_CAP_SQUARE) {
+            Vector2 c = p[0];
+            SvgAddQuad(sh, (Vector2){ c.x - hw, c.y - hw }, (Vector2){ c.x + hw, c.y - hw },
+                           (Vector2){ c.x + hw, c.y + hw }, (Vector2){ c.x - hw, c.y + hw });
+        }
+        free(p);
+        return;
+    }
+    if (n < 2) {
+        free(p);
+        return;
+    }
 
-    if (dr < 0 || dr >= BOARD_SIZE || dc < 0 || dc >= BOARD_SIZE) return false;
-    if (sr == dr && sc == dc) return false;
+    int segs = closed ? n : n - 1;
+    for (int i = 0; i < segs; i++) {
+        Vector2 a = p[i], b = p[(i + 1) % n];
+        float len = hypotf(b.x - a.x, b.y - a.y);
+        Vector2 nv = { -(b.y - a.y) / len * hw, (b.x - a.x) / len * hw };
+        SvgAddQuad(sh, (Vector2){ a.x + nv.x, a.y + nv.y }, (Vector2){ b.x + nv.x, b.y + nv.y },
+                       (Vector2){ b.x - nv.x, b.y - nv.y }, (Vector2){ a.x - nv.x, a.y - nv.y });
+    }
 
-    Piece p = board[sr][sc];
-    if (board[dr][dc].color == p.color) return false;
+    for (int i = closed ? 0 : 1; i < (closed ? n : n - 1); i++) {
+        Vector2 v = p[i], a = p[(i + n - 1) % n], b = p[(i + 1) % n];
 
-    int rDiff = dr - sr;
-    int cDiff = dc - sc;
+        if (join == SVG_JOIN_ROUND) {
+            SvgAddCircle(sh, v, hw, true);
+            continue;
+        }
 
-    switch(p.type){
-        case PAWN:{
-            int dir = (p.color == WHITE_PIECE) ? -1 : 1;
+        float l0 = hypotf(v.x - a.x, v.y - a.y), l1 = hypotf(b.x - v.x, b.y - v.y);
+        Vector2 d0 = { (v.x - a.x) / l0, (v.y - a.y) / l0 }, d1 = { (b.x - v.x) / l1, (b.y - v.y) / l1 };
+        float cross = d0.x * d1.y - d0.y * d1.x;
+        if (fabsf(cross) < 1e-6f) continue;
 
-            if (cDiff == 0 && rDiff == dir && board[dr][dc].type == EMPTY)
-                return true;
+        // the gap opens on the side away from the turn
+        float side = (cross > 0) ? -1.0f : 1.0f;
+        Vector2 n0 = { -d0.y * hw * side, d0.x * hw * side }, n1 = { -d1.y * hw * side, d1.x * hw * side };
+        Vector2 e0 = { v.x + n0.x, v.y + n0.y }, e1 = { v.x + n1.x, v.y + n1.y };
 
-            if (!p.moved && cDiff == 0 && rDiff == 2 * dir && board[dr][dc].type == EMPTY && board[sr + dir][sc].type == EMPTY)
-                return true;
+        float mx = n0.x + n1.x, my = n0.y + n1.y, ml = hypotf(mx, my);
+        float cosHalf = (ml > 1e-6f) ? (mx * n0.x + my * n0.y) / (ml * hw) : 0;
 
-            if (abs(cDiff) == 1 && rDiff == dir) {
-                if (board[dr][dc].type != EMPTY)
-                    return true;
+        if (join == SVG_JOIN_MITER && cosHalf > 1.0f / SVG_MITER_LIMIT) {
+            Vector2 tip = { v.x + mx / ml * hw / cosHalf, v.y + my / ml * hw / cosHalf };
+            SvgAddQuad(sh, v, e0, tip, e1);
+        } else {
+            Vector2 tri[3] = { v, e0, e1 };
+            SvgAddPolygon(sh, tri, 3, true);
+        }
+    }
 
-                if (dr == enPassantTargetRow && dc == enPassantTargetCol && p.color != enPassantPawnColor){
+    if (!closed && cap != SVG_CAP_BUTT) {
+        for (int end = 0; end < 2; end++) {
+            Vector2 v = end ? p[n - 1] : p[0], w = end ? p[n - 2] : p[1];
+            if (cap == SVG_CAP_ROUND) {
+                SvgAddCircle(sh, v, hw, true);
+                continue;
+            }
+            float len = hypotf(v.x - w.x, v.y - w.y);
+            Vector2 d = { (v.x - w.x) / len * hw, (v.y - w.y) / len * hw };
+            Vector2 nv = { -d.y, d.x };
+            SvgAddQuad(sh, (Vector2){ v.x + nv.x, v.y + nv.y }, (Vector2){ v.x + nv.x + d.x, v.y + nv.y + d.y },
+                           (Vector2){ v.x - nv.x + d.x, v.y - nv.y + d.y }, (Vector2){ v.x - nv.x, v.y - nv.y });
+        }
+    }
+    free(p);
+}
+
+/**
+ * @brief Reads attribute name="value" of the tag starting at tag
+ *
+ * @return false if the tag has no such attribute
+ */
+bool SvgAttribute(const char* tag, const char* tagEnd, const char* name, char* out, int size) {
+    size_t len = strlen(name);
+
+    for (const char* p = tag; p + len + 2 < tagEnd; p++) {
+        if ((p[-1] == ' ' || p[-1] == '\t' || p[-1] == '\n' || p[-1] == '\r') &&
+            strncmp(p, name, len) == 0 && p[len] == '=' && (p[len + 1] == '"' || p[len + 1] == '\'')) {
+            char quote = p[len + 1];
+            const char* v = p + len + 2;
+            int n = 0;
+            while (v < tagEnd && *v != quote && n < size - 1) out[n++] = *v++;
+            out[n] = '\0';
+            return true;
+        }
+    }
+    return false;
+}
+
+float SvgFloatAttribute(const char* tag, const char* tagEnd, const char* name, float fallback) {
+    char value[64];
+    return SvgAttribute(tag, tagEnd, name, value, sizeof(value)) ? strtof(value, NULL) : fallback;
+}
+
+/**
+ * @brief Parses a paint value, "none" turns the paint off
+ */
+void SvgParsePaint(const char* value, bool* has, Color* color) {
+    if (strcmp(value, "none") == 0) {
+        *has = false;
+        return;
+    }
+
+    unsigned int rgb = 0;
+    size_t len = strlen(value);
+    if (value[0] == '#' && len == 4) {
+        rgb = (unsigned int)strtoul(value + 1, NULL, 16);
+        rgb = ((rgb & 0xF00) * 0x1100) | ((rgb & 0x0F0) * 0x110) | ((rgb & 0x00F) * 0x11);
+    } else if (value[0] == '#' && len == 7) {
+        rgb = (unsigned int)strtoul(value + 1, NULL, 16);
+    } else if (strcmp(value, "white") == 0) {
+        rgb = 0xFFFFFF;
+    } else if (strcmp(value, "black") != 0) {
+        return;     // unsupported color syntax, keep the inherited paint
+    }
+
+    *has = true;
+    *color = (Color){ (rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF, 255 };
+}
+
+void SvgApplyStyle(SvgStyle* st, const char* tag, const char* tagEnd) {
+    char value[32];
+
+    if (SvgAttribute(tag, tagEnd, "fill", value, sizeof(value))) SvgParsePaint(value, &st->hasFill, &st->fill);
+    if (SvgAttribute(tag, tagEnd, "stroke", value, sizeof(value))) SvgParsePaint(value, &st->hasStroke, &st->stroke);
+    st->strokeWidth = SvgFloatAttribute(tag, tagEnd, "stroke-width", st->strokeWidth);
+
+    if (SvgAttribute(tag, tagEnd, "stroke-linecap", value, sizeof(value))) {
+        if (strcmp(value, "round") == 0) st->cap = SVG_CAP_ROUND;
+        else if (strcmp(value, "square") == 0) st->cap = SVG_CAP_SQUARE;
+        else st->cap = SVG_CAP_BUTT;
+    }
+    if (SvgAttribute(tag, tagEnd, "stroke-linejoin", value, sizeof(value))) {
+        if (strcmp(value, "round") == 0) st->join = SVG_JOIN_ROUND;
+        else if (strcmp(value, "bevel") == 0) st->join = SVG_JOIN_BEVEL;
+        else st->join = SVG_JOIN_MITER;
+    }
+}
+
+/**
+ * @brief Fills then strokes one flattened element
+ */
+void SvgPaint(SvgCanvas* cv, const SvgPath* path, const SvgStyle* st) {
+    SvgShape sh = {0};
+
+    if (st->hasFill) {
+        for (int i = 0; i < path->subs; i++)
+            SvgAddPolygon(&sh, path->pts + path->subStart[i], path->subCount[i], false);
+        SvgFillShape(cv, &sh, st->fill);
+        sh.count = 0;
+    }
+
+    if (st->hasStroke && st->strokeWidth > 0) {
+        for (int i = 0; i < path->subs; i++)
+            SvgStrokePolyline(&sh, path->pts + path->subStart[i], path->subCount[i], path->subClosed[i],
+                              st->strokeWidth * cv->scale / 2.0f, st->cap, st->join);
+        SvgFillShape(cv, &sh, st->stroke);
+    }
+    free(sh.edges);
+}
+
+/**
+ * @brief Rasterizes an SVG document into a size x size RGBA8 image
+ * The viewBox is fitted into the square keeping its aspect ratio
+ *
+ * @return image with data == NULL if the document has no <svg> element
+ */
+Image RasterizeSvg(const char* svg, int size) {
+    Image img = {0};
+    if (size <= 0 || strstr(svg, "<svg") == NULL) return img;
+
+    SvgCanvas cv = { calloc((size_t)size * size * 4, sizeof(float)), size, 1.0f, 0, 0 };
+    if (cv.rgba == NULL) return img;
+
+    SvgStyle stack[SVG_MAX_DEPTH];
+    int depth = 0;
+    stack[0] = (SvgStyle){ true, BLACK, false, BLANK, 1.0f, SVG_CAP_BUTT, SVG_JOIN_MITER };
+
+    for (const char* p = strchr(svg, '<'); p != NULL; p = strchr(p, '<')) {
+        if (strncmp(p, "<!--", 4) == 0) {
+            const char* end = strstr(p, "-->");
+            p = (end != NULL) ? end + 3 : p + strlen(p);
+            continue;
+        }
+
+        const char* tagEnd = p;
+        char quote = 0;
+        while (*tagEnd != '\0' && (*tagEnd != '>' || quote)) {
+            if (*tagEnd == '"' || *tagEnd == '\'') quote = (quote == *tagEnd) ? 0 : (quote ? quote : *tagEnd);
+            tagEnd++;
+        }
+        if (*tagEnd == '\0') break;
+
+        const char* tag = p + 1;
+        p = tagEnd + 1;
+        if (*tag == '?' || *tag == '!') continue;
+
+        if (*tag == '/') {
+            if (strncmp(tag, "/g", 2) == 0 && depth > 0) depth--;
+            continue;
+        }
+
+        bool selfClosing = tagEnd[-1] == '/';
+        int nameLen = (int)strcspn(tag, " \t\r\n/>");
+        SvgStyle st = stack[depth];
+        SvgApplyStyle(&st, tag, tagEnd);
+
+        if (nameLen == 3 && strncmp(tag, "svg", 3) == 0) {
+            char viewBox[64];
+            float vx = 0, vy = 0, vw = SvgFloatAttribute(tag, tagEnd, "width", (float)size);
+            float vh = SvgFloatAttribute(tag, tagEnd, "height", vw);
+            if (SvgAttribute(tag, tagEnd, "viewBox", viewBox, sizeof(viewBox))) {
+                const char* v = viewBox;
+                vx = SvgNumber(&v);
+                vy = SvgNumber(&v);
+                vw = SvgNumber(&v);
+                vh = SvgNumber(&v);
+            }
+            float extent = (vw > vh) ? vw : vh;
+            cv.scale = (extent > 0) ? size / extent : 1.0f;
+            cv.originX = vx - (extent - vw) / 2;
+            cv.originY = vy - (extent - vh) / 2;
+            stack[depth] = st;
+            continue;
+        }
+
+        if (nameLen == 1 && tag[0] == 'g') {
+            if (!selfClosing && depth + 1 < SVG_MAX_DEPTH) stack[++depth] = st;
+            continue;
+        }
+
+        SvgPath path = {0};
+        char value[16384];
+
+        if (nameLen == 4 && strncmp(tag, "path", 4) == 0) {
+            if (SvgAttribute(tag, tagEnd, "d", value, sizeof(value))) SvgParsePathData(&path, &cv, value);
+        } else if (nameLen == 6 && strncmp(tag, "circle", 6) == 0) {
+            float cx = SvgFloatAttribute(tag, tagEnd, "cx", 0), cy = SvgFloatAttribute(tag, tagEnd, "cy", 0);
+            float r = SvgFloatAttribute(tag, tagEnd, "r", 0);
+            SvgPathBegin(&path);
+            SvgPathPoint(&path, &cv, cx + r, cy);
+            SvgArc(&path, &cv, (Vector2){ cx + r, cy }, r, r, 0, false, true, (Vector2){ cx - r, cy });
+            SvgArc(&path, &cv, (Vector2){ cx - r, cy }, r, r, 0, false, true, (Vector2){ cx + r, cy });
+            path.subClosed[0] = true;
+        } else if (nameLen == 4 && strncmp(tag, "line", 4) == 0) {
+            SvgPathBegin(&path);
+            SvgPathPoint(&path, &cv, SvgFloatAttribute(tag, tagEnd, "x1", 0), SvgFloatAttribute(tag, tagEnd, "y1", 0));
+            SvgPathPoint(&path, &cv, SvgFloatAttribute(tag, tagEnd, "x2", 0), SvgFloatAttribute(tag, tagEnd, "y2", 0));
+            st.hasFill = false;
+        } else if (nameLen == 4 && strncmp(tag, "rect", 4) == 0) {
+            float x = SvgFloatAttribute(tag, tagEnd, "x", 0), y = SvgFloatAttribute(tag, tagEnd, "y", 0);
+            float w = SvgFloatAttribute(tag, tagEnd, "width", 0), h = SvgFloatAttribute(tag, tagEnd, "height", 0);
+            SvgPathBegin(&path);
+            SvgPathPoint(&path, &cv, x, y);
+            SvgPathPoint(&path, &cv, x + w, y);
+            SvgPathPoint(&path, &cv, x + w, y + h);
+            SvgPathPoint(&path, &cv, x, y + h);
+            path.subClosed[0] = true;
+        }
+
+        if (path.subs > 0) SvgPaint(&cv, &path, &st);
+        SvgFreePath(&path);
+    }
+
+    // premultiplied float -> straight RGBA8
+    unsigned char* data = malloc((size_t)size * size * 4);
+    if (data != NULL) {
+        for (size_t i = 0; i < (size_t)size * size; i++) {
+            float a = cv.rgba[i * 4 + 3];
+            for (int k = 0; k < 3; k++) {
+                float c = (a > 0) ? cv.rgba[i * 4 + k] / a : 0;
+                data[i * 4 + k] = (unsigned char)(fminf(c, 1.0f) * 255.0f + 0.5f);
+            }
+            data[i * 4 + 3] = (unsigned char)(fminf(a, 1.0f) * 255.0f + 0.5f);
+        }
+        img = (Image){ data, size, size, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    }
+    free(cv.rgba);
+    return img;
+}
+
+//===========================================================================
+// ASSET MANAGEMENT FUNCTIONS
+//===========================================================================
+
+const char* pieceNames[] = { "", "pawn", "rook", "knight", "bishop", "queen", "king" };
+const char* colorNames[] = { "white", "black" };
+
+/**
+ * @brief Piece size in pixels for a given tile size
+ */
+int PieceSizeFor(int tile) {
+    return (int)(tile * PIECE_SCALE);
+}
+
+bool svgFallbackWarned = false;
+
+/**
+ * @brief Rasterizes one piece at exactly size x size pixels
+ * Renders assets/SVG with RasterizeSvg. Only if the SVG is missing or
+ * unreadable does it fall back to a bicubic resize of the 128px PNG,
+ * with a warning the first time.
+ *
+ * Safe to call off the main thread (CPU only, no GL calls)
+ */
+Image RasterizePiece(int colorIdx, PieceType type, int size) {
+    char path[128];
+    Image img = {0};
+
+    sprintf(path, "assets/SVG/%s_%s.svg", colorNames[colorIdx], pieceNames[type]);
+    char* svg = LoadFileText(path);
+
+    if (svg != NULL) {
+        img = RasterizeSvg(svg, size);
+        UnloadFileText(svg);
+    }
+
+    if (img.data == NULL) {
+        if (!svgFallbackWarned) {
+            svgFallbackWarned = true;
+            TraceLog(LOG_WARNING, "ASSETS: could not rasterize %s, resizing PNG pieces instead", path);
+        }
+        sprintf(path, "assets/PNG/%s_%s.png", colorNames[colorIdx], pieceNames[type]);
+        img = LoadImage(path);
+    }
+
+    if (img.data != NULL && (img.width != size || img.height != size))
+        ImageResize(&img, size, size);
+
+    return img;
+}
+
+/**
+ * @brief Builds the CPU side of the piece atlas
+ * Layout: 7 columns (PieceType, column 0 unused) x 2 rows (color)
+ */
+Image BuildAtlasImage(int cellSize) {
+    Image atlas = GenImageColor(cellSize * 7, cellSize * 2, BLANK);
+
+    for (int colorIdx = 0; colorIdx < 2; colorIdx++) {
+        for (int t = PAWN; t <= KING; t++) {
+            Image piece = RasterizePiece(colorIdx, t, cellSize);
+            if (piece.data == NULL) continue;
+
+            ImageDraw(&atlas, piece,
+                      (Rectangle){0, 0, piece.width, piece.height},
+                      (Rectangle){t * cellSize, colorIdx * cellSize, cellSize, cellSize},
+                      WHITE);
+            UnloadImage(piece);
+        }
+    }
+    return atlas;
+}
+
+/**
+ * @brief Uploads a finished atlas image and swaps it in
+ * Must run on the main thread, the previous texture is released
+ */
+void SwapAtlas(Image img, int cellSize) {
+    Texture2D tex = LoadTextureFromImage(img);
+    SetTextureFilter(tex, TEXTURE_FILTER_BILINEAR);
+    UnloadImage(img);
+
+    if (pieceAtlas.id != 0) UnloadTexture(pieceAtlas);
+    pieceAtlas = tex;
+    atlasCellSize = cellSize;
+    atlasGeneration++;
+}
+
+/**
+ * @brief Worker thread body: rasterizes the atlas for atlasJobCellSize
+ */
+void* AtlasWorker(void* arg) {
+    (void)arg;
+    Image img = BuildAtlasImage(atlasJobCellSize);
+
+    pthread_mutex_lock(&atlasMutex);
+    atlasJobImage = img;
+    atlasState = JOB_READY;
+    pthread_mutex_unlock(&atlasMutex);
+    return NULL;
+}
+
+/**
+ * @brief Loads the piece atlas for the initial tile size
+ * Done synchronously so the very first frame already has pieces
+ */
+void LoadAssets(){
+    int cellSize = PieceSizeFor(tileSize);
+    SwapAtlas(BuildAtlasImage(cellSize), cellSize);
+}
+
+/**
+ * @brief Called once per frame: swaps in a finished atlas and starts a new
+ * job when the piece size no longer matches. Only one job runs at a time,
+ * so dragging the window edge coalesces into the latest size.
+ *
+ * Until the new atlas is ready, the old one is drawn scaled.
+ */
+void UpdateAtlas() {
+    pthread_mutex_lock(&atlasMutex);
+    JobState state = atlasState;
+    pthread_mutex_unlock(&atlasMutex);
+
+    if (state == JOB_BUSY) return;
+
+    if (state == JOB_READY) {
+        pthread_join(atlasThread, NULL);
+        SwapAtlas(atlasJobImage, atlasJobCellSize);
+        atlasJobImage = (Image){0};
+        atlasState = JOB_IDLE;
+    }
+
+    int wanted = PieceSizeFor(wallActive ? wallTileSize : tileSize);
+    if (wanted == atlasCellSize) return;
+
+    atlasJobCellSize = wanted;
+    atlasState = JOB_BUSY;
+    if (pthread_create(&atlasThread, NULL, AtlasWorker, NULL) != 0) {
+        // no thread available, rasterize inline rather than keep a stale atlas
+        atlasState = JOB_IDLE;
+        SwapAtlas(BuildAtlasImage(wanted), wanted);
+    }
+}
+
+/**
+ * @brief Releases the atlas texture
+ * Waits for an in-flight rasterization job first
+ */
+void UnloadAssets() {
+    if (atlasState != JOB_IDLE) {
+        pthread_join(atlasThread, NULL);
+        UnloadImage(atlasJobImage);
+        atlasState = JOB_IDLE;
+    }
+    UnloadTexture(pieceAtlas);
+}
+
+/**
+ * @brief Recomputes tileSize so the board and sidebar fit the window
+ */
+void UpdateLayout() {
+    int byWidth = (GetScreenWidth() - SIDEBAR_WIDTH) / BOARD_SIZE;
+    int byHeight = GetScreenHeight() / BOARD_SIZE;
+
+    tileSize = (byWidth < byHeight) ? byWidth : byHeight;
+    if (tileSize < MIN_TILE_SIZE) tileSize = MIN_TILE_SIZE;
+}
+
+//===========================================================================
+// BOARD INITIALIZATION FUNCTION
+//===========================================================================
+
+/**
+ * @brief Set Up Standard chess Sarting position
+ *
+ * Chess Board Setup:
+ *  0 | r n b q k b n r
+ *  1 | p p p p p p p p
+ *  2 |
+ *  3 |
+ *  4 |
+ *  5 |
+ *  6 | P P P P P P P P
+ *  7 | R N B Q K B N R
+ */                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                      
+void InitBoard() {
+    memset(board, 0, sizeof(board));
+
+    board[0][0] = (Piece){ROOK, BLACK_PIECE, false, false};
+    board[0][1] = (Piece){KNIGHT, BLACK_PIECE, false, false};
+    board[0][3] = (Piece){QUEEN, BLACK_PIECE, false, false};
+    board[0][2] = (Piece){BISHOP, BLACK_PIECE, false, false};
+    board[0][4] = (Piece){KING, BLACK_PIECE, false, false};
+    board[0][5] = (Piece){BISHOP, BLACK_PIECE, false, false};
+    board[0][6] = (Piece){KNIGHT, BLACK_PIECE, false, false};
+    board[0][7] = (Piece){ROOK, BLACK_PIECE, false, false};
+
+    for (int c = 0; c < 8; c++) 
+        board[1][c] = (Piece){PAWN, BLACK_PIECE, false, false};
+
+    for (int c = 0; c < 8; c++) 
+        board[6][c] = (Piece){PAWN, WHITE_PIECE, false, false};
+
+    board[7][0] = (Piece){ROOK, WHITE_PIECE, false, false};
+    board[7][1] = (Piece){KNIGHT, WHITE_PIECE, false, false};
+    board[7][2] = (Piece){BISHOP, WHITE_PIECE, false, false};
+    board[7][3] = (Piece){QUEEN, WHITE_PIECE, false, false};
+    board[7][4] = (Piece){KING, WHITE_PIECE, false, false};
+    board[7][5] = (Piece){BISHOP, WHITE_PIECE, false, false};
+    board[7][6] = (Piece){KNIGHT, WHITE_PIECE, false, false};
+    board[7][7] = (Piece){ROOK, WHITE_PIECE, false, false};
+
+    for(int r = 2; r < 6; r++)
+        for(int c = 0; c < 8; c++)
+            board[r][c] = (Piece){EMPTY, NONE_PIECE, false, false};
+
+    ResetEnPassant();
+}
+
+//===========================================================================
+// RENDERING FUNCTIONS
+//===========================================================================
+
+/**
+ * @brief Renders the Chess Board with selection Highlights
+ * Renders 64 squares with alternating colors and visual feedback for:
+ * - Selected Square (Yellow Highlights)
+ * - Valid Moves (circles for empty squares, rings for captures)
+ */
+void DrawBoard() {
+    for(int r = 0; r < BOARD_SIZE; r++) {
+        for(int c = 0; c < BOARD_SIZE; c++) {
+            Color sq = ((r + c) % 2 == 0) ? TILE_LIGHT : TILE_DARK;
+            DrawRectangle(c * tileSize, r * tileSize, tileSize, tileSize, sq);
+
+            if (selectedRow != -1 && IsValidMove(selectedRow, selectedCol, r, c)) {
+                if (!TestMoveForCheck(board[selectedRow][selectedCol].color, selectedRow, selectedCol, r, c)){
+                    if(board[r][c].type == EMPTY) {
+                        DrawCircle(c * tileSize + tileSize/2, r * tileSize + tileSize/2, MOVE_CIRCLE_RADIUS, MOVE_CIRCLE_COLOR);
+                    }else{
+                        DrawCircleLines(c * tileSize + tileSize/2, r * tileSize + tileSize/2, CAPTURE_CIRCLE_RADIUS, MOVE_CIRCLE_COLOR);
+                    }
+                }
+            }
+
+            if (r == selectedRow && c == selectedCol) {
+                DrawRectangle(c * tileSize, r * tileSize, tileSize, tileSize, Fade(YELLOW, 0.4f));
+            }
+        }
+    }
+
+    DrawMateHint();
+}
+
+/**
+ * @brief Render all pieces on the board
+ * Incudes special highlighting for kings in Check
+ */
+void DrawPieces() {
+    bool wCheck = IsInCheck(WHITE_PIECE);
+    bool bCheck = IsInCheck(BLACK_PIECE);
+    int pieceSize = PieceSizeFor(tileSize);
+
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            Piece p = board[r][c];
+            if (p.type == EMPTY) continue;
+            if (p.type == KING) {
+                if ((p.color == WHITE_PIECE && wCheck) || (p.color == BLACK_PIECE && bCheck)){
+                    DrawRectangle(c * tileSize, r * tileSize, tileSize, tileSize, CHECK_COLOR);
+                }
+            }
+
+            Rectangle dest = {
+                c * tileSize + (tileSize - pieceSize) / 2,
+                r * tileSize + (tileSize - pieceSize) / 2,
+                pieceSize,
+                pieceSize
+            };
+
+            DrawPieceSprite(p.color, p.type, dest);
+        }
+    }
+}
+
+/**
+ * @brief Draws one piece from the atlas into dest
+ * Pixel exact when dest matches atlasCellSize, scaled while a new atlas is pending
+ */
+void DrawPieceSprite(PieceColor color, PieceType type, Rectangle dest) {
+    int colorIdx = (color == WHITE_PIECE) ? 0 : 1;
+    Rectangle src = { type * atlasCellSize, colorIdx * atlasCellSize, atlasCellSize, atlasCellSize };
+
+    DrawTexturePro(pieceAtlas, src, dest, (Vector2){0, 0}, 0, WHITE);
+}
+
+/**
+ * @brief Renders the side panel: turn card, check warning, game over dialog
+ */
+void DrawSidebar() {
+    int sideX = BOARD_SIZE * tileSize;
+    int boardPx = BOARD_SIZE * tileSize;
+
+    DrawRectangle(sideX, 0, SIDEBAR_WIDTH, GetScreenHeight(), GetColor(0x252525FF));
+    DrawRectangle(sideX, 0, 5, GetScreenHeight(), GetColor(0x333333FF));
+
+    DrawText("PROJECT CHESS", sideX + 30, 30, 22, GetColor(0x69923EFF));
+    DrawRectangle(sideX + 40, 60, 140, 2, DARKGRAY);
+
+
+    DrawText("CURRENT MOVE", sideX + 30, 100, 14, LIGHTGRAY);
+
+    Color cardColor = (turn == WHITE_PIECE) ? RAYWHITE : GetColor(0x383838FF);
+    Color textColor = (turn == WHITE_PIECE) ? BLACK : RAYWHITE;
+
+    DrawRectangleRounded((Rectangle){sideX + 25, 125, 190, 80}, 0.2, 10, 
+                       Fade(BLACK, 0.3f));
+    DrawRectangleRounded((Rectangle){sideX + 20, 120, 190, 80}, 0.2, 10, cardColor);
+
+    const char* turnText = (turn == WHITE_PIECE) ? "WHITE" : "BLACK";
+    int tw = MeasureText(turnText, 28);
+    DrawText(turnText, sideX + 20 + (190 - tw) / 2, 145, 28, textColor);
+
+
+    if (IsInCheck(turn)) {
+
+        float pulse = (sinf(GetTime() * 10.0f) * 0.5f) + 0.5f;
+        DrawRectangleRounded((Rectangle){sideX + 50, 215, 130, 30}, 0.5, 10, Fade(RED, 0.2f + (pulse * 0.3f)));
+        DrawText("KING IN CHECK", sideX + 65, 224, 12, RED);
+    }
+
+    DrawMateStatus(sideX + 30, 260);
+
+    if (gameOver) {
+        DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(), Fade(BLACK, 0.6f));
+
+        // give the final position a second before the dialog covers it
+        if (InputClock() - gameOverTime < GAME_OVER_DELAY) return;
+
+        Rectangle resBox = { boardPx / 2 - 200, boardPx / 2 - 100, 400, 200 };
+        DrawRectangleRounded(resBox, 0.1, 10, GetColor(0x202020FF));
+        DrawRectangleRoundedLines(resBox, 0.1, 10, TILE_DARK);
+
+        DrawText("GAME OVER", resBox.x + 110, resBox.y + 30, 30, TILE_DARK);
+
+        int resW = MeasureText(gameResult, 20);
+        DrawText(gameResult, resBox.x + (400 - resW) / 2, resBox.y + 80, 20, RAYWHITE);
+
+        Rectangle btn = { resBox.x + 100, resBox.y + 130, 200, 45 };
+        bool hover = CheckCollisionPointRec(GetMousePosition(), btn);
+        DrawRectangleRounded(btn, 0.2, 10, hover ? TILE_DARK : DARKGRAY);
+        DrawText("PLAY AGAIN", btn.x + 45, btn.y + 12, 18, hover ? BLACK : RAYWHITE);
+
+        if (hover && !replayActive && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+            RecordEvent(EVENT_RESTART, 0, 0);
+            RestartGame();
+        }
+    } else {
+        DrawText("L-Click: Select/Move", sideX + 35, GetScreenHeight() - 60, 14, WHITE);
+        DrawText("R-Click: Deselect", sideX + 45, GetScreenHeight() - 40, 14, WHITE);
+        DrawText("M: Find Mate", sideX + 55, GetScreenHeight() - 80, 14, WHITE);
+    }
+}
+
+//===========================================================================
+// INPUT HANDLING FUNCTION
+//===========================================================================
+
+/**
+ * @brief Process mouse input for piece selection and movement
+ * Implements two-step interaction: select piece -> select destination
+ */
+void HandleInput() {
+    if (replayActive) return;
+    if(promotionActive) return;
+    if (gameOver) return;
+
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        int col = GetMouseX() / tileSize;
+        int row = GetMouseY() / tileSize;
+
+        RecordEvent(EVENT_CLICK, row, col);
+        HandleBoardClick(row, col);
+    }
+}
+
+/**
+ * @brief Applies a click on a board square
+ * Shared by live input and replay so both take the exact same path
+ *
+ * @param row Clicked row, >= 8 means outside the board
+ * @param col Clicked column, >= 8 means outside the board
+ */
+void HandleBoardClick(int row, int col) {
+    if (promotionActive || gameOver) return;
+
+    if (col < 0 || row < 0 || col >= 8 || row >= 8) {
+        selectedRow = -1;
+        return;
+    }
+
+    if(selectedRow == -1){
+        if (board[row][col].color == turn) {
+            selectedRow = row;
+            selectedCol = col;
+        }
+    }else{
+        if (board[row][col].color == turn) {
+            selectedRow = row;
+            selectedCol = col;
+        } else if (MovePiece(selectedRow, selectedCol, row, col)) {
+                turn = (turn == WHITE_PIECE) ? BLACK_PIECE : WHITE_PIECE;
+            BroadcastSync();
+            if (IsCheckmate(turn)) {
+                gameOver = true;
+                gameOverTime = InputClock();
+                sprintf(gameResult, "Checkmate! %s Wins", (turn == BLACK_PIECE ? "White" : "Black"));
+            } else if (!HasAnyValidMove(turn)){
+                gameOver = true;
+                gameOverTime = InputClock();
+                strcpy(gameResult, "Stalemate! Draw");
+            }
+            selectedRow = -1;
+        } else {
+            selectedRow = -1;
+        }
+    }
+}
+
+/**
+ * @brief Replaces the promoting pawn with the chosen piece
+ */
+void ChoosePromotion(PieceType type) {
+    if (!promotionActive) return;
+
+    board[promotionRow][promotionCol].type = type;
+    promotionActive = false;
+    BroadcastSync();
+}
+
+/**
+ * @brief Starts a new game from the standard position
+ */
+void RestartGame() {
+    InitBoard();
+    turn = WHITE_PIECE;
+    gameOver = false;
+    selectedRow = -1;
+    ResetEnPassant();
+    BroadcastSync();
+}
+
+//===========================================================================
+// MOVE VALIDATION FUNCTIONS
+//===========================================================================
+
+/**
+ * @brief Validates move according to chess piece rules (FIDE rules)
+ * Performs basic validation without considering King Safety
+ *
+ * @param sr Source Row
+ * @param sc Source Column
+ * @param dr Destination Row
+ * @param dc Destination Column
+ *
+ * @return true if move follows piece movement rules
+ */
+bool IsValidMove(int sr, int sc, int dr, int dc) {
+    PROFILE_COUNT(COUNT_IS_VALID_MOVE);
+
+    if (dr < 0 || dr >= BOARD_SIZE || dc < 0 || dc >= BOARD_SIZE) return false;
+    if (sr == dr && sc == dc) return false;
+
+    Piece p = board[sr][sc];
+    if (board[dr][dc].color == p.color) return false;
+
+    int rDiff = dr - sr;
+    int cDiff = dc - sc;
+
+    switch(p.type){
+        case PAWN:{
+            int dir = (p.color == WHITE_PIECE) ? -1 : 1;
+
+            if (cDiff == 0 && rDiff == dir && board[dr][dc].type == EMPTY)
+                return true;
+
+            if (!p.moved && cDiff == 0 && rDiff == 2 * dir && board[dr][dc].type == EMPTY && board[sr + dir][sc].type == EMPTY)
+                return true;
+
+            if (abs(cDiff) == 1 && rDiff == dir) {
+                if (board[dr][dc].type != EMPTY)
+                    return true;
+
+                if (dr == enPassantTargetRow && dc == enPassantTargetCol && p.color != enPassantPawnColor){
                     int pawnRow = (p.color == WHITE_PIECE) ? dr + 1 : dr - 1;
                     if (pawnRow >= 0 && pawnRow < BOARD_SIZE &&
                         board[pawnRow][dc].type == PAWN &&
@@ -454,368 +1770,3444 @@ bool IsValidMove(int sr, int sc, int dr, int dc) {
                     }
                 }
             }
-            return false;
+            return false;
+        }
+
+        case ROOK:
+            return (sr == dr || sc == dc) && IsPathClear(sr, sc, dr, dc);
+
+        case KNIGHT:
+            return (abs(rDiff) == 2 && abs(cDiff) == 1) || (abs(rDiff) == 1 && abs(cDiff) == 2);
+
+        case BISHOP:
+            return (abs(rDiff) == abs(cDiff)) && IsPathClear(sr, sc, dr, dc);
+
+        case QUEEN:
+            return (sr == dr || sc == dc || abs(rDiff) == abs(cDiff)) && IsPathClear(sr, sc, dr, dc);
+
+        case KING:{
+            if(abs(rDiff) <= 1 && abs(cDiff) <= 1) return true;
+
+            if(!p.moved && rDiff == 0 && abs(cDiff) == 2){
+                int rookCol = (cDiff > 0) ? 7 : 0;
+
+                // Castling conditions:
+                // 1. Rook hasn't moved
+                // 2. Path is clear
+                // 3. King not currently in check
+                // 4. King doesn't pass through attacked squares
+                if (board[sr][rookCol].type == ROOK && !board[sr][rookCol].moved && IsPathClear(sr, sc, sr, rookCol)){
+
+                    if (IsInCheck(p.color)) return false;
+
+                    return !TestMoveForCheck(p.color, sr, sc, sr, sc + (cDiff > 0 ? 1 : -1));
+                }
+            }
+            return false;
+        }
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Executes a move with all side effects
+ * Performs safety check, handles special moves, updates board states
+ *
+ * @param sr Source Row
+ * @param sc Source Column
+ * @param dr Destination Row
+ * @param dc Destination Column
+ *
+ * @returns true if move was successfully executed
+ */
+bool MovePiece(int sr, int sc, int dr, int dc) {
+    // ========================================================================
+    // PRE-MOVE VALIDATION
+    // ========================================================================
+    if (!IsValidMove(sr, sc, dr, dc)) return false;
+
+    Piece p = board[sr][sc];
+
+    if (TestMoveForCheck(p.color, sr, sc, dr, dc)) return false;
+
+    // ========================================================================
+    // EN PASSANT CAPTURE HANDLING
+    // ========================================================================
+    bool isEnPassantCapture = (p.type == PAWN && dr == enPassantTargetRow && dc == enPassantTargetCol && p.color != enPassantPawnColor);
+
+    if (isEnPassantCapture) {
+        int captureRow = (p.color == WHITE_PIECE) ? dr + 1 : dr - 1;
+        board[captureRow][dc] = (Piece){EMPTY, NONE_PIECE, false, false};
+    }
+
+    // ========================================================================
+    // EN PASSANT TARGET SETTING
+    // ========================================================================
+    if (p.type == PAWN && abs(dr - sr) == 2) {
+        enPassantTargetRow = (sr + dr) / 2;
+        enPassantTargetCol = sc;
+        enPassantPawnColor = p.color;
+    } else {
+        ResetEnPassant();
+    }
+
+// ======================== 
+// PAWN PROMOTION TRIGGER 
+// ========================
+if (p.type == PAWN &&
+   ((p.color == WHITE_PIECE && dr == 0) ||
+    (p.color == BLACK_PIECE && dr == 7))) {
+
+    promotionActive = true;
+    promotionRow = dr;
+    promotionCol = dc;
+    promotionColor = p.color;
+}
+
+    // ========================================================================
+    // CASTLING HANDLING
+    // ========================================================================
+    if (p.type == KING && abs(dc - sc) == 2) {
+        // Determine rook positions
+        int rookCol = (dc > sc) ? 7 : 0;
+        int newRookCol = (dc > sc) ? dc - 1 : dc + 1;
+
+        board[dr][newRookCol] = board[sr][rookCol];
+        board[dr][newRookCol].moved = true;
+
+
+        board[sr][rookCol] = (Piece){EMPTY, NONE_PIECE, false, false};
+    }
+
+    // ========================================================================
+    // FINAL BOARD UPDATE
+    // ========================================================================
+    p.moved = true;
+    board[dr][dc] = p;
+    board[sr][sc] = (Piece){EMPTY, NONE_PIECE, false, false};
+
+    return true;
+}
+/**
+ * @brief Determine if specified king is in check
+ *
+ * @param color color of king to check
+ *
+ * @return true if king is under attack
+ */
+bool IsInCheck(PieceColor color) {
+    PROFILE_COUNT(COUNT_IS_IN_CHECK);
+    int kr = -1, kc = -1;
+
+    // ========================================================================
+    // FIND THE KING
+    // ========================================================================
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            if (board[r][c].type == KING && board[r][c].color == color) {
+                kr = r;
+                kc = c;
+                break;
+            }
+        }
+        if (kr != -1) break;
+    }
+
+    if (kr == -1) return false;
+
+    // ========================================================================
+    // CHECK FOR ATTACKING PIECES
+    // ========================================================================
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            Piece p = board[r][c];
+
+            if (p.type == EMPTY || p.color == color) continue;
+
+            // ================================================================
+            // SPECIAL CASE: PAWN ATTACKS
+            // ================================================================
+            if (p.type == PAWN) {
+                int dir = (p.color == WHITE_PIECE) ? -1 : 1;
+                if (r + dir == kr && abs(c - kc) == 1)
+                    return true;
+            }
+            // ================================================================
+            // OTHER PIECES: USE VALID MOVE CHECK
+            // ================================================================
+            else if (IsValidMove(r, c, kr, kc)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Check if player has any legal moves
+ *
+ * @param color Player color to check
+ *
+ * @return true if at least one legal move exists
+ */
+bool HasAnyValidMove(PieceColor color) {
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            if (board[r][c].color == color) {
+                for(int dr = 0; dr < 8; dr++){
+                    for(int dc = 0; dc < 8; dc++){
+                        if (IsValidMove(r, c, dr, dc) && !TestMoveForCheck(color, r, c, dr, dc)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * IsCheckmate(): Determine if player is in checkmate
+ * Checkmate = King is in check AND has no legal moves
+ *
+ * @param color Player color to check
+ * @return true if player is checkmated
+ */
+bool IsCheckmate(PieceColor color){
+    return IsInCheck(color) && !HasAnyValidMove(color);
+}
+
+/**
+ * @brief Determine if player is in check
+ *
+ * @param color Player color to check
+ *
+ * @return true if player is checkmated
+ */
+bool IsCheckMate(PieceColor color){
+    return IsInCheck(color) && !HasAnyValidMove(color);
+}
+
+/**
+ * @brief Determine if neither side can ever mate
+ * Covers K vs K and a single minor piece against a bare king
+ *
+ * @return true if the position is a dead draw
+ */
+bool IsInsufficientMaterial(){
+    int minors = 0;
+
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            PieceType t = board[r][c].type;
+            if (t == PAWN || t == ROOK || t == QUEEN) return false;
+            if (t == KNIGHT || t == BISHOP) minors++;
+        }
+    }
+    return minors <= 1;
+}
+
+/**
+ * @brief  Check if path between two squares is unobstructed
+ *
+ * @param sr Source row
+ * @param sc Source column
+ * @param dr Destination row
+ * @param dc Destination column
+ *
+ * @return true if all intermediate squares are empty
+ */
+bool IsPathClear(int sr, int sc, int dr, int dc) {
+    int rs = (dr > sr) ? 1 : (dr < sr) ? -1 : 0;
+    int cs = (dc > sc) ? 1 : (dc < sc) ? -1 : 0;
+
+    for (int r = sr + rs, c = sc + cs; r != dr || c != dc; r += rs, c += cs) {
+        if (board[r][c].type != EMPTY)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Simulate move to check if it leaves king in check
+ * Uses temporary board modification to test move consequences
+ *
+ * @param color Color of moving Player
+ * @param sr Source Row
+ * @param sc Source Column
+ * @param dr Destination Row
+ * @param dc Destination Column
+ *
+ * @return true if move would leave king in check
+ */
+bool TestMoveForCheck(PieceColor color, int sr, int sc, int dr, int dc) {
+    PROFILE_COUNT(COUNT_TEST_MOVE_FOR_CHECK);
+
+    Piece src = board[sr][sc];
+    Piece dst = board[dr][dc];
+    Piece capturedPawn = {EMPTY, NONE_PIECE, false, false};
+    int capturedRow = -1, capturedCol = -1;
+
+    // ========================================================================
+    // EN PASSANT CAPTURE SIMULATION
+    // ========================================================================
+    bool isEP = (src.type == PAWN && dr == enPassantTargetRow && dc == enPassantTargetCol && src.color != enPassantPawnColor);
+
+    if (isEP) {
+        capturedRow = (src.color == WHITE_PIECE) ? dr + 1 : dr - 1;
+        capturedCol = dc;
+        capturedPawn = board[capturedRow][capturedCol];
+        board[capturedRow][capturedCol] = (Piece){EMPTY, NONE_PIECE, false, false};
+    }
+
+    // ========================================================================
+    // TEMPORARY MOVE EXECUTION
+    // ========================================================================
+    board[dr][dc] = src;
+    board[sr][sc] = (Piece){EMPTY, NONE_PIECE, false, false};
+
+    // ========================================================================
+    // CHECK DETECTION
+    // ========================================================================
+    bool inCheck = IsInCheck(color);
+
+    // ========================================================================
+    // BOARD RESTORATION
+    // ========================================================================
+    board[sr][sc] = src;
+    board[dr][dc] = dst;
+
+    if (isEP) {
+        board[capturedRow][capturedCol] = capturedPawn;
+    }
+
+    return inCheck;
+}
+
+/**
+ * @brief Clear en Passant tracking variables
+ * Called after each move (except when a pawn moves two squares)
+ */
+void ResetEnPassant() {
+    enPassantTargetRow = -1;
+    enPassantTargetCol = -1;
+    enPassantPawnColor = NONE_PIECE;
+}
+
+/**
+ * @brief Monotonic clock in microseconds, usable without a window
+ */
+uint64_t NowMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Copies the rules globals into a snapshot
+ */
+void SaveGameState(GameState* g) {
+    memcpy(g->board, board, sizeof(board));
+    g->turn = turn;
+    g->gameOver = gameOver;
+    g->promotionActive = promotionActive;
+    g->promotionRow = promotionRow;
+    g->promotionCol = promotionCol;
+    g->promotionColor = promotionColor;
+    g->enPassantTargetRow = enPassantTargetRow;
+    g->enPassantTargetCol = enPassantTargetCol;
+    g->enPassantPawnColor = enPassantPawnColor;
+}
+
+/**
+ * @brief Restores a snapshot into the rules globals
+ */
+void LoadGameState(const GameState* g) {
+    memcpy(board, g->board, sizeof(board));
+    turn = g->turn;
+    gameOver = g->gameOver;
+    promotionActive = g->promotionActive;
+    promotionRow = g->promotionRow;
+    promotionCol = g->promotionCol;
+    promotionColor = g->promotionColor;
+    enPassantTargetRow = g->enPassantTargetRow;
+    enPassantTargetCol = g->enPassantTargetCol;
+    enPassantPawnColor = g->enPassantPawnColor;
+}
+
+/**
+ * @brief Draws the Promotion Menu for Piece Selection 
+ */
+void DrawPromotionMenu(){
+
+    if (!promotionActive) return;
+
+    DrawRectangle(0, 0,
+        GetScreenWidth(),
+        GetScreenHeight(),
+        Fade(BLACK, 0.6f));
+
+    Rectangle box = {
+        BOARD_SIZE*tileSize/2 - 160,
+        BOARD_SIZE*tileSize/2 - 60,
+        320,
+        120
+    };
+
+    DrawRectangleRounded(box, 0.2f, 10, GetColor(0x202020FF));
+    DrawText("Choose Promotion", box.x + 50, box.y + 10, 20, RAYWHITE);
+
+    PieceType options[4] = {QUEEN, ROOK, BISHOP, KNIGHT};
+
+    for (int i = 0; i < 4; i++) {
+
+        Rectangle slot = {
+            box.x + 20 + i*70,
+            box.y + 50,
+            60,
+            60
+        };
+
+        DrawRectangleRounded(slot, 0.2f, 10, DARKGRAY);
+
+        DrawPieceSprite(promotionColor, options[i], (Rectangle){slot.x + 5, slot.y + 5, 50, 50});
+
+        if (!replayActive && CheckCollisionPointRec(GetMousePosition(), slot)
+            && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+
+            RecordEvent(EVENT_PROMOTE, options[i], 0);
+            ChoosePromotion(options[i]);
+        }
+
+    }
+}
+//===========================================================================
+// SPECTATOR WALL FUNCTIONS
+//===========================================================================
+
+/**
+ * @brief Restarts one wall game from the standard position
+ * Caller must have the main game saved, this goes through the globals
+ */
+void ResetWallBoard(WallBoard* wb) {
+    InitBoard();
+    turn = WHITE_PIECE;
+    gameOver = false;
+    promotionActive = false;
+    SaveGameState(&wb->game);
+
+    wb->nextMoveTime = InputClock() + 0.5 + (rand() % 1500) / 1000.0;
+    wb->dirty = true;
+    wb->checkRow = wb->checkCol = -1;
+    wb->lastMove[0] = -1;
+    wb->plies = 0;
+    wb->quietPlies = 0;
+}
+
+/**
+ * @brief Sets up count independent games (clamped to 1..WALL_MAX_BOARDS)
+ */
+void InitWall(int count) {
+    if (count < 1) count = 1;
+    if (count > WALL_MAX_BOARDS) count = WALL_MAX_BOARDS;
+
+    GameState saved;
+    SaveGameState(&saved);
+
+    wallCount = count;
+    for (int i = 0; i < wallCount; i++)
+        ResetWallBoard(&wallBoards[i]);
+
+    LoadGameState(&saved);
+}
+
+/**
+ * @brief Switches between the single board and the spectator wall
+ * The main game is left untouched while the wall is shown
+ */
+void ToggleWall() {
+    wallActive = !wallActive;
+    if (!wallActive) return;
+
+    if (wallCount == 0) InitWall(wallRequested);
+    UpdateWallLayout();
+}
+
+/**
+ * @brief Fits the grid to the window and recreates the cache texture
+ * Every board is marked dirty since the cache starts out empty
+ */
+void UpdateWallLayout() {
+    wallCols = (int)ceilf(sqrtf((float)wallCount));
+    wallRows = (wallCount + wallCols - 1) / wallCols;
+
+    int cellW = GetScreenWidth() / wallCols;
+    int cellH = GetScreenHeight() / wallRows;
+    int cell = (cellW < cellH) ? cellW : cellH;
+
+    wallTileSize = (cell - WALL_GAP) / BOARD_SIZE;
+    if (wallTileSize < 1) wallTileSize = 1;
+
+    if (wallCache.id != 0) UnloadRenderTexture(wallCache);
+    wallCache = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+
+    BeginTextureMode(wallCache);
+    ClearBackground(GetColor(0x181818FF));
+    EndTextureMode();
+
+    for (int i = 0; i < wallCount; i++) wallBoards[i].dirty = true;
+}
+
+/**
+ * @brief Plays a random legal move for the side to move
+ * Stands in for a live feed. Promotions always pick a queen.
+ *
+ * @return true if a move was played
+ */
+bool PlayRandomMove(int lastMove[4]) {
+    static int moves[BOARD_SIZE * BOARD_SIZE * 28][4];
+    int count = 0;
+
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            if (board[r][c].color != turn) continue;
+            for (int dr = 0; dr < 8; dr++) {
+                for (int dc = 0; dc < 8; dc++) {
+                    if (IsValidMove(r, c, dr, dc) && !TestMoveForCheck(turn, r, c, dr, dc)) {
+                        moves[count][0] = r;
+                        moves[count][1] = c;
+                        moves[count][2] = dr;
+                        moves[count][3] = dc;
+                        count++;
+                    }
+                }
+            }
+        }
+    }
+    if (count == 0) return false;
+
+    int* m = moves[rand() % count];
+    if (!MovePiece(m[0], m[1], m[2], m[3])) return false;
+
+    if (promotionActive) {
+        board[promotionRow][promotionCol].type = QUEEN;
+        promotionActive = false;
+    }
+    memcpy(lastMove, m, sizeof(int) * 4);
+    return true;
+}
+
+/**
+ * @brief Advances every wall game whose next move is due
+ * Finished games restart after a short pause
+ */
+void StepWallGames() {
+    double now = InputClock();
+    GameState saved;
+    bool swapped = false;
+
+    for (int i = 0; i < wallCount; i++) {
+        WallBoard* wb = &wallBoards[i];
+        if (now < wb->nextMoveTime) continue;
+
+        if (!swapped) {
+            SaveGameState(&saved);
+            swapped = true;
+        }
+
+        if (wb->game.gameOver) {
+            ResetWallBoard(wb);
+            continue;
+        }
+
+        LoadGameState(&wb->game);
+
+        if (PlayRandomMove(wb->lastMove)) {
+            turn = (turn == WHITE_PIECE) ? BLACK_PIECE : WHITE_PIECE;
+
+            // wb->game still holds the position before the move
+            int* m = wb->lastMove;
+            bool irreversible = wb->game.board[m[0]][m[1]].type == PAWN || wb->game.board[m[2]][m[3]].type != EMPTY;
+            wb->quietPlies = irreversible ? 0 : wb->quietPlies + 1;
+            wb->plies++;
+        }
+
+        wb->checkRow = wb->checkCol = -1;
+        if (IsInCheck(turn)) {
+            for (int r = 0; r < 8; r++)
+                for (int c = 0; c < 8; c++)
+                    if (board[r][c].type == KING && board[r][c].color == turn) {
+                        wb->checkRow = r;
+                        wb->checkCol = c;
+                    }
+        }
+
+        // draws by material, 50-move rule or ply cap restart the board like a mate
+        if (!HasAnyValidMove(turn) || IsInsufficientMaterial() ||
+            wb->quietPlies >= FIFTY_MOVE_PLIES || wb->plies >= WALL_MAX_PLIES) {
+            gameOver = true;
+            wb->nextMoveTime = now + 3.0;
+        } else {
+            wb->nextMoveTime = now + 0.3 + (rand() % 1200) / 1000.0;
+        }
+
+        SaveGameState(&wb->game);
+        wb->dirty = true;
+    }
+
+    if (swapped) LoadGameState(&saved);
+}
+
+/**
+ * @brief Top-left pixel of wall board i
+ */
+Vector2 WallBoardOrigin(int i) {
+    int cell = wallTileSize * BOARD_SIZE + WALL_GAP;
+    int offX = (GetScreenWidth() - cell * wallCols) / 2;
+    int offY = (GetScreenHeight() - cell * wallRows) / 2;
+
+    return (Vector2){ offX + (i % wallCols) * cell + WALL_GAP / 2,
+                      offY + (i / wallCols) * cell + WALL_GAP / 2 };
+}
+
+/**
+ * @brief Redraws the changed boards into wallCache
+ *
+ * Squares of all dirty boards go first, then all their pieces. Every piece
+ * comes from the one atlas texture, so raylib emits them as a single batch.
+ * Boards that did not change are not touched at all.
+ */
+void RenderWallCache() {
+    if (wallCacheGeneration != atlasGeneration) {
+        for (int i = 0; i < wallCount; i++) wallBoards[i].dirty = true;
+        wallCacheGeneration = atlasGeneration;
+    }
+
+    bool anyDirty = false;
+    for (int i = 0; i < wallCount; i++) anyDirty |= wallBoards[i].dirty;
+    if (!anyDirty) return;
+
+    int t = wallTileSize;
+    int pieceSize = PieceSizeFor(t);
+
+    BeginTextureMode(wallCache);
+
+    for (int i = 0; i < wallCount; i++) {
+        WallBoard* wb = &wallBoards[i];
+        if (!wb->dirty) continue;
+        Vector2 o = WallBoardOrigin(i);
+
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                Color sq = ((r + c) % 2 == 0) ? TILE_LIGHT : TILE_DARK;
+                DrawRectangle(o.x + c * t, o.y + r * t, t, t, sq);
+            }
+        }
+
+        if (wb->lastMove[0] != -1) {
+            DrawRectangle(o.x + wb->lastMove[1] * t, o.y + wb->lastMove[0] * t, t, t, SELECTED_TILE);
+            DrawRectangle(o.x + wb->lastMove[3] * t, o.y + wb->lastMove[2] * t, t, t, SELECTED_TILE);
+        }
+        if (wb->checkRow != -1) {
+            DrawRectangle(o.x + wb->checkCol * t, o.y + wb->checkRow * t, t, t, CHECK_COLOR);
+        }
+    }
+
+    for (int i = 0; i < wallCount; i++) {
+        WallBoard* wb = &wallBoards[i];
+        if (!wb->dirty) continue;
+        Vector2 o = WallBoardOrigin(i);
+
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                Piece p = wb->game.board[r][c];
+                if (p.type == EMPTY) continue;
+
+                Rectangle dest = {
+                    o.x + c * t + (t - pieceSize) / 2,
+                    o.y + r * t + (t - pieceSize) / 2,
+                    pieceSize,
+                    pieceSize
+                };
+                DrawPieceSprite(p.color, p.type, dest);
+            }
+        }
+        wb->dirty = false;
+    }
+
+    EndTextureMode();
+}
+
+/**
+ * @brief Presents the wall: one textured quad plus the footer text
+ */
+void DrawWall() {
+    Rectangle src = { 0, 0, wallCache.texture.width, -wallCache.texture.height };
+    DrawTextureRec(wallCache.texture, src, (Vector2){0, 0}, WHITE);
+
+    DrawText(TextFormat("SPECTATOR WALL - %d boards   G: back to game", wallCount),
+             10, GetScreenHeight() - 20, 14, LIGHTGRAY);
+}
+
+/**
+ * @brief Releases the wall cache texture
+ */
+void UnloadWall() {
+    if (wallCache.id != 0) UnloadRenderTexture(wallCache);
+    wallCache = (RenderTexture2D){0};
+}
+
+//===========================================================================
+// PROFILING FUNCTIONS
+//===========================================================================
+
+#ifdef CHESS_PROFILE
+
+const char* zoneNames[ZONE_COUNT] = { "HandleInput", "DrawBoard", "DrawPieces", "Sidebar", "Wall" };
+const char* counterNames[COUNTER_COUNT] = { "IsValidMove", "IsInCheck", "TestMoveForCheck" };
+
+THREAD_LOCAL ProfileFrame profileCurrent = {0};
+ProfileFrame profileHistory[PROFILE_HISTORY];
+int profileHistoryCount = 0;
+int profileHistoryHead = 0;
+long profileFrameIndex = 0;
+double profileFrameStart = 0;
+ProfileFrame profilePending;        // finished frame waiting for the next begin to know its length
+bool profileHasPending = false;
+bool profileOverlay = false;
+FILE* profileTrace = NULL;
+
+/**
+ * @brief Accumulates the time since start into a zone of the current frame
+ */
+void ProfileAddZone(ProfileZone zone, double start) {
+    profileCurrent.zoneMs[zone] += (GetTime() - start) * 1000.0;
+}
+
+/**
+ * @brief Opens a CSV trace, one row per frame from now on
+ */
+void ProfileStartTrace(const char* path) {
+    if (profileTrace != NULL) fclose(profileTrace);
+
+    profileTrace = fopen(path, "w");
+    if (profileTrace == NULL) {
+        TraceLog(LOG_WARNING, "PROFILE: could not open trace file %s", path);
+        return;
+    }
+
+    fprintf(profileTrace, "frame,frame_ms,work_ms");
+    for (int z = 0; z < ZONE_COUNT; z++) fprintf(profileTrace, ",%s_ms", zoneNames[z]);
+    for (int c = 0; c < COUNTER_COUNT; c++) fprintf(profileTrace, ",%s", counterNames[c]);
+    fprintf(profileTrace, "\n");
+
+    TraceLog(LOG_INFO, "PROFILE: tracing to %s", path);
+}
+
+/**
+ * @brief Completes the pending frame: its frame time runs from its begin to now
+ * Then it goes into the history and the trace
+ */
+void ProfileCommitFrame(double now) {
+    if (!profileHasPending) return;
+    profileHasPending = false;
+
+    profilePending.frameMs = (now - profileFrameStart) * 1000.0;
+
+    profileHistory[profileHistoryHead] = profilePending;
+    profileHistoryHead = (profileHistoryHead + 1) % PROFILE_HISTORY;
+    if (profileHistoryCount < PROFILE_HISTORY) profileHistoryCount++;
+
+    if (profileTrace != NULL) {
+        fprintf(profileTrace, "%ld,%.3f,%.3f", profileFrameIndex, profilePending.frameMs, profilePending.workMs);
+        for (int z = 0; z < ZONE_COUNT; z++) fprintf(profileTrace, ",%.4f", profilePending.zoneMs[z]);
+        for (int c = 0; c < COUNTER_COUNT; c++) fprintf(profileTrace, ",%ld", profilePending.counters[c]);
+        fprintf(profileTrace, "\n");
+    }
+    profileFrameIndex++;
+}
+
+/**
+ * @brief Commits the previous frame, resets the per-frame record and
+ * handles the overlay/trace keys
+ */
+void ProfileBeginFrame() {
+    double now = GetTime();
+    ProfileCommitFrame(now);
+
+    memset(&profileCurrent, 0, sizeof(profileCurrent));
+    profileFrameStart = now;
+
+    if (IsKeyPressed(KEY_F3)) profileOverlay = !profileOverlay;
+
+    if (IsKeyPressed(KEY_F4)) {
+        if (profileTrace != NULL) {
+            fclose(profileTrace);
+            profileTrace = NULL;
+            TraceLog(LOG_INFO, "PROFILE: trace closed");
+        } else {
+            ProfileStartTrace("profile_trace.csv");
+        }
+    }
+}
+
+/**
+ * @brief Draws the instrumentation panel: last completed frame and average over history
+ */
+void DrawProfileOverlay() {
+    if (profileHistoryCount == 0) return;
+    ProfileFrame last = profileHistory[(profileHistoryHead + PROFILE_HISTORY - 1) % PROFILE_HISTORY];
+
+    ProfileFrame avg = {0};
+    for (int i = 0; i < profileHistoryCount; i++) {
+        for (int z = 0; z < ZONE_COUNT; z++) avg.zoneMs[z] += profileHistory[i].zoneMs[z];
+        for (int c = 0; c < COUNTER_COUNT; c++) avg.counters[c] += profileHistory[i].counters[c];
+        avg.workMs += profileHistory[i].workMs;
+        avg.frameMs += profileHistory[i].frameMs;
+    }
+    int n = (profileHistoryCount > 0) ? profileHistoryCount : 1;
+
+    Rectangle box = { 10, 10, 300, 30 + (ZONE_COUNT + COUNTER_COUNT + 2) * 16 };
+    DrawRectangleRec(box, Fade(BLACK, 0.75f));
+    DrawText(TextFormat("PROFILE   last     avg(%d)", profileHistoryCount), box.x + 10, box.y + 8, 12, GOLD);
+
+    int y = box.y + 28;
+    DrawText(TextFormat("frame      %6.2f   %6.2f ms", last.frameMs, avg.frameMs / n), box.x + 10, y, 12, RAYWHITE);
+    y += 16;
+    DrawText(TextFormat("work       %6.2f   %6.2f ms", last.workMs, avg.workMs / n), box.x + 10, y, 12, RAYWHITE);
+    y += 16;
+
+    for (int z = 0; z < ZONE_COUNT; z++, y += 16) {
+        DrawText(TextFormat("%-16s %6.3f   %6.3f ms", zoneNames[z], last.zoneMs[z], avg.zoneMs[z] / n),
+                 box.x + 10, y, 12, LIGHTGRAY);
+    }
+    for (int c = 0; c < COUNTER_COUNT; c++, y += 16) {
+        DrawText(TextFormat("%-16s %6ld   %6ld", counterNames[c], last.counters[c], avg.counters[c] / n),
+                 box.x + 10, y, 12, SKYBLUE);
+    }
+
+    if (profileTrace != NULL) DrawText("REC", box.x + box.width - 35, box.y + 8, 12, RED);
+}
+
+/**
+ * @brief Closes the current frame's work time and draws the overlay
+ * The frame is committed by the next ProfileBeginFrame, once its full
+ * length (including EndDrawing and the frame cap wait) is known.
+ * Call inside BeginDrawing, right before EndDrawing.
+ */
+void ProfileEndFrame() {
+    profileCurrent.workMs = (GetTime() - profileFrameStart) * 1000.0;
+    profilePending = profileCurrent;
+    profileHasPending = true;
+
+    if (profileOverlay) DrawProfileOverlay();
+}
+
+/**
+ * @brief Commits the last frame, flushes and closes the trace file
+ */
+void ProfileShutdown() {
+    ProfileCommitFrame(GetTime());
+    if (profileTrace != NULL) fclose(profileTrace);
+    profileTrace = NULL;
+}
+
+#endif
+
+//===========================================================================
+// INPUT RECORD / REPLAY FUNCTIONS
+//===========================================================================
+
+/**
+ * @brief Opens a recording file, every semantic input is appended to it
+ * Format: one event per line "frame time TYPE a b", '#' starts a comment
+ */
+bool StartRecording(const char* path) {
+    recordFile = fopen(path, "w");
+    if (recordFile == NULL) {
+        TraceLog(LOG_WARNING, "REPLAY: could not open %s for recording", path);
+        return false;
+    }
+
+    srand(REPLAY_SEED);
+    fprintf(recordFile, "# chess-gui input recording v1\n");
+    fprintf(recordFile, "# frame time type a b\n");
+    TraceLog(LOG_INFO, "REPLAY: recording to %s", path);
+    return true;
+}
+
+/**
+ * @brief Clock for game logic that has to repeat under record/replay
+ * Driven by the frame counter while recording or replaying, so an --uncapped
+ * replay does the same work on each frame as the recording did
+ */
+double InputClock() {
+    if (replayActive || recordFile != NULL) return inputFrame / REPLAY_FPS;
+    return GetTime();
+}
+
+/**
+ * @brief Appends one event to the recording (no-op when not recording)
+ */
+void RecordEvent(InputEventType type, int a, int b) {
+    if (recordFile == NULL) return;
+
+    fprintf(recordFile, "%ld %.4f %s %d %d\n", inputFrame, GetTime(), eventNames[type], a, b);
+}
+
+/**
+ * @brief Writes the END marker so replays run for the same number of frames
+ */
+void StopRecording() {
+    if (recordFile == NULL) return;
+
+    RecordEvent(EVENT_END, 0, 0);
+    fclose(recordFile);
+    recordFile = NULL;
+}
+
+/**
+ * @brief Parses a recording and switches the game into replay mode
+ * Live mouse and keyboard input is ignored while replaying
+ *
+ * @return false if the file is missing or malformed
+ */
+bool LoadReplay(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        TraceLog(LOG_ERROR, "REPLAY: could not open %s", path);
+        return false;
+    }
+
+    int capacity = 64;
+    replayEvents = malloc(sizeof(InputEvent) * capacity);
+    replayCount = 0;
+    if (replayEvents == NULL) {
+        fclose(f);
+        return false;
+    }
+
+    char line[BUFFER_SIZE];
+    int lineNo = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineNo++;
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        InputEvent e = {0};
+        char name[16];
+        if (sscanf(line, "%ld %lf %15s %d %d", &e.frame, &e.time, name, &e.a, &e.b) != 5) {
+            TraceLog(LOG_ERROR, "REPLAY: %s:%d: malformed event", path, lineNo);
+            fclose(f);
+            return false;
+        }
+
+        int type = -1;
+        for (int t = EVENT_CLICK; t <= EVENT_END; t++)
+            if (strcmp(name, eventNames[t]) == 0) type = t;
+        if (type == -1) {
+            TraceLog(LOG_ERROR, "REPLAY: %s:%d: unknown event %s", path, lineNo, name);
+            fclose(f);
+            return false;
+        }
+        e.type = type;
+
+        long lastFrame = (replayCount > 0) ? replayEvents[replayCount - 1].frame : 0;
+        if (e.frame < lastFrame) {
+            TraceLog(LOG_ERROR, "REPLAY: %s:%d: frame %ld goes backwards or is negative", path, lineNo, e.frame);
+            fclose(f);
+            return false;
+        }
+
+        if (replayCount == capacity) {
+            capacity *= 2;
+            InputEvent* grown = realloc(replayEvents, sizeof(InputEvent) * capacity);
+            if (grown == NULL) {
+                fclose(f);
+                return false;
+            }
+            replayEvents = grown;
+        }
+        replayEvents[replayCount++] = e;
+    }
+    fclose(f);
+
+    long frames = (replayCount > 0) ? replayEvents[replayCount - 1].frame : 0;
+    replayFrameMs = malloc(sizeof(double) * (frames + 1));
+    if (replayFrameMs == NULL) return false;
+    replayFrameCapacity = frames + 1;
+    replayFrameCount = 0;
+    replayNext = 0;
+    replayActive = true;
+    srand(REPLAY_SEED);
+
+    TraceLog(LOG_INFO, "REPLAY: %d events over %ld frames from %s", replayCount, frames, path);
+    return true;
+}
+
+/**
+ * @brief Called at the start of every frame while replaying
+ * Records the previous frame's duration and injects this frame's events
+ *
+ * @return false once the END marker (or the end of the file) is reached
+ */
+bool ReplayStep() {
+    double now = GetTime();
+    if (replayLastFrameStart > 0 && replayFrameCount < replayFrameCapacity)
+        replayFrameMs[replayFrameCount++] = (now - replayLastFrameStart) * 1000.0;
+    replayLastFrameStart = now;
+
+    while (replayNext < replayCount && replayEvents[replayNext].frame <= inputFrame) {
+        InputEvent e = replayEvents[replayNext++];
+
+        switch (e.type) {
+            case EVENT_CLICK:   HandleBoardClick(e.a, e.b); break;
+            case EVENT_PROMOTE: ChoosePromotion((PieceType)e.a); break;
+            case EVENT_RESTART: RestartGame(); break;
+            case EVENT_WALL:    ToggleWall(); break;
+            case EVENT_SOLVE:   RequestMateSolve(); break;
+            case EVENT_END:     return false;
+        }
+    }
+    return replayNext < replayCount;
+}
+
+int CompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Prints the frame-time summary and histogram of the replay
+ * Optionally writes the histogram as CSV (bucket_ms,count)
+ */
+void ReplayReport(const char* histogramPath) {
+    if (replayFrameCount == 0) return;
+
+    long buckets[HISTOGRAM_BUCKETS] = {0};
+    double total = 0;
+    for (long i = 0; i < replayFrameCount; i++) {
+        int b = (int)replayFrameMs[i];
+        buckets[(b < HISTOGRAM_BUCKETS) ? b : HISTOGRAM_BUCKETS - 1]++;
+        total += replayFrameMs[i];
+    }
+
+    qsort(replayFrameMs, replayFrameCount, sizeof(double), CompareDouble);
+    long n = replayFrameCount;
+
+    printf("replay: %ld frames, %.1f ms total\n", n, total);
+    printf("frame ms: mean %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+           total / n, replayFrameMs[n / 2], replayFrameMs[n * 95 / 100],
+           replayFrameMs[n * 99 / 100], replayFrameMs[n - 1]);
+
+    long peak = 1;
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) if (buckets[b] > peak) peak = buckets[b];
+
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        if (buckets[b] == 0) continue;
+        printf("%3d%s ms %7ld |", b, (b == HISTOGRAM_BUCKETS - 1) ? "+" : " ", buckets[b]);
+        for (int i = 0; i < (int)(buckets[b] * 50 / peak); i++) putchar('#');
+        putchar('\n');
+    }
+
+    if (histogramPath != NULL) {
+        FILE* f = fopen(histogramPath, "w");
+        if (f != NULL) {
+            fprintf(f, "bucket_ms,count\n");
+            for (int b = 0; b < HISTOGRAM_BUCKETS; b++) fprintf(f, "%d,%ld\n", b, buckets[b]);
+            fclose(f);
+        }
+    }
+
+    free(replayFrameMs);
+    free(replayEvents);
+    replayFrameMs = NULL;
+    replayEvents = NULL;
+}
+
+//===========================================================================
+// SPECTATOR BROADCAST FUNCTIONS
+//===========================================================================
+
+/*
+ * Embedded broadcast server (--serve [port]), Linux only (epoll).
+ *
+ * Viewers connect over TCP and first send either the line "CHESS\n" (raw
+ * framing: 1 length byte + message) or a WebSocket upgrade request (binary
+ * frames). They receive a snapshot, then one delta per change.
+ *
+ * Messages, all integers little endian:
+ *   header  type(1) seq(4) emitMicros(8)
+ *   'S'     header + 64 square codes + turn(1)
+ *   'D'     header + turn(1) + count(1) + count * (square(1), code(1))
+ * square = row * 8 + col, code = PieceType | PieceColor << 3
+ *
+ * The render thread only diffs the board and pushes the encoded message
+ * into a queue; all socket work happens on the network thread. A viewer
+ * whose unsent backlog exceeds VIEWER_OUT_LIMIT is disconnected.
+ */
+#ifdef __linux__
+
+#define BROADCAST_QUEUE_SIZE 1024
+#define BROADCAST_MAX_MESSAGE 96
+#define BROADCAST_MAX_DELTA 16
+#define BROADCAST_HEADER 13
+#define VIEWER_IN_SIZE 1024
+#define VIEWER_OUT_LIMIT (64 * 1024)
+
+/**
+ * ViewerState enum: connection phase of a spectator
+ */
+typedef enum ViewerState{
+    VIEWER_HANDSHAKE,
+    VIEWER_RAW,
+    VIEWER_WEBSOCKET
+} ViewerState;
+
+/**
+ * Viewer struct: one connected spectator, owned by the network thread
+ *
+ * out/outHead/outLen: pending bytes are out[outHead .. outLen)
+ * seqFloor: sequence number of the snapshot it was sent, older deltas are skipped
+ */
+typedef struct Viewer{
+    int fd;
+    int index;
+    ViewerState state;
+    char in[VIEWER_IN_SIZE];
+    int inLen;
+    unsigned char* out;
+    size_t outHead;
+    size_t outLen;
+    size_t outCap;
+    bool wantWrite;
+    uint32_t seqFloor;
+} Viewer;
+
+/**
+ * BroadcastMessage struct: one encoded snapshot or delta
+ */
+typedef struct BroadcastMessage{
+    unsigned char data[BROADCAST_MAX_MESSAGE];
+    int len;
+    uint32_t seq;
+} BroadcastMessage;
+
+// main thread side: last state that went out
+bool broadcastRunning = false;
+Piece broadcastBoard[BOARD_SIZE][BOARD_SIZE];
+PieceColor broadcastTurn = NONE_PIECE;
+uint32_t broadcastSeq = 0;
+
+// shared between the render thread and the network thread, guarded by broadcastMutex
+pthread_mutex_t broadcastMutex = PTHREAD_MUTEX_INITIALIZER;
+BroadcastMessage broadcastQueue[BROADCAST_QUEUE_SIZE];
+int broadcastQueueHead = 0;
+int broadcastQueueCount = 0;
+bool broadcastOverflow = false;
+BroadcastMessage broadcastSnapshot;
+
+// network thread side
+pthread_t broadcastThread;
+int broadcastListenFd = -1;
+int broadcastWakeFd = -1;
+int broadcastEpollFd = -1;
+volatile bool broadcastStopping = false;
+Viewer** viewers = NULL;
+int viewerCount = 0;
+int viewerCapacity = 0;
+Viewer** deadViewers = NULL;    // dropped during the current epoll batch, freed after it
+int deadCount = 0;
+int deadCapacity = 0;
+
+// statistics, written by the network thread
+long broadcastDropped = 0;
+long long broadcastBytesSent = 0;
+
+void PutU32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+void PutU64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+uint32_t GetU32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+uint64_t GetU64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+unsigned char PieceCode(Piece p) {
+    return (unsigned char)(p.type | (p.color << 3));
+}
+
+/**
+ * @brief Encodes the current board as a snapshot message
+ */
+int EncodeSnapshot(unsigned char* out, uint32_t seq, uint64_t micros) {
+    out[0] = 'S';
+    PutU32(out + 1, seq);
+    PutU64(out + 5, micros);
+
+    for (int sq = 0; sq < 64; sq++)
+        out[BROADCAST_HEADER + sq] = PieceCode(board[sq / 8][sq % 8]);
+    out[BROADCAST_HEADER + 64] = (unsigned char)turn;
+
+    return BROADCAST_HEADER + 65;
+}
+
+/**
+ * @brief Pushes a message for the network thread, never blocks on I/O
+ * On overflow the oldest message is dropped and everyone gets resynced
+ */
+void BroadcastEnqueue(const unsigned char* data, int len, uint32_t seq, const unsigned char* snap, int snapLen) {
+    pthread_mutex_lock(&broadcastMutex);
+
+    if (broadcastQueueCount == BROADCAST_QUEUE_SIZE) {
+        broadcastQueueHead = (broadcastQueueHead + 1) % BROADCAST_QUEUE_SIZE;
+        broadcastQueueCount--;
+        broadcastOverflow = true;
+    }
+
+    BroadcastMessage* m = &broadcastQueue[(broadcastQueueHead + broadcastQueueCount) % BROADCAST_QUEUE_SIZE];
+    memcpy(m->data, data, len);
+    m->len = len;
+    m->seq = seq;
+    broadcastQueueCount++;
+
+    memcpy(broadcastSnapshot.data, snap, snapLen);
+    broadcastSnapshot.len = snapLen;
+    broadcastSnapshot.seq = seq;
+
+    pthread_mutex_unlock(&broadcastMutex);
+
+    uint64_t one = 1;
+    if (write(broadcastWakeFd, &one, sizeof(one)) < 0) { /* counter saturated, thread is awake anyway */ }
+}
+
+/**
+ * @brief Sends whatever changed since the last call as a delta
+ * Called after a move, a promotion choice and a restart. Cheap: a 64
+ * square diff plus a short critical section.
+ */
+void BroadcastSync() {
+    if (!broadcastRunning) return;
+
+    unsigned char delta[BROADCAST_MAX_MESSAGE];
+    int count = 0;
+
+    for (int sq = 0; sq < 64; sq++) {
+        Piece now = board[sq / 8][sq % 8];
+        Piece was = broadcastBoard[sq / 8][sq % 8];
+        if (now.type == was.type && now.color == was.color) continue;
+
+        if (count < BROADCAST_MAX_DELTA) {
+            delta[BROADCAST_HEADER + 2 + count * 2] = (unsigned char)sq;
+            delta[BROADCAST_HEADER + 3 + count * 2] = PieceCode(now);
+        }
+        count++;
+    }
+    if (count == 0 && turn == broadcastTurn) return;
+
+    uint32_t seq = ++broadcastSeq;
+    uint64_t micros = NowMicros();
+
+    unsigned char snap[BROADCAST_MAX_MESSAGE];
+    int snapLen = EncodeSnapshot(snap, seq, micros);
+
+    if (count > BROADCAST_MAX_DELTA) {
+        // a restart touches most squares, the snapshot is smaller
+        BroadcastEnqueue(snap, snapLen, seq, snap, snapLen);
+    } else {
+        delta[0] = 'D';
+        PutU32(delta + 1, seq);
+        PutU64(delta + 5, micros);
+        delta[BROADCAST_HEADER] = (unsigned char)turn;
+        delta[BROADCAST_HEADER + 1] = (unsigned char)count;
+        BroadcastEnqueue(delta, BROADCAST_HEADER + 2 + count * 2, seq, snap, snapLen);
+    }
+
+    memcpy(broadcastBoard, board, sizeof(board));
+    broadcastTurn = turn;
+}
+
+/**
+ * @brief Minimal SHA-1, only used for the WebSocket handshake
+ */
+void Sha1(const unsigned char* data, size_t len, unsigned char digest[20]) {
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    size_t total = ((len + 8) / 64 + 1) * 64;
+    unsigned char* msg = calloc(total, 1);
+
+    memcpy(msg, data, len);
+    msg[len] = 0x80;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 0; i < 8; i++) msg[total - 1 - i] = (unsigned char)(bits >> (8 * i));
+
+    for (size_t chunk = 0; chunk < total; chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++)
+            w[i] = (uint32_t)msg[chunk + 4*i] << 24 | (uint32_t)msg[chunk + 4*i + 1] << 16 |
+                   (uint32_t)msg[chunk + 4*i + 2] << 8 | msg[chunk + 4*i + 3];
+        for (int i = 16; i < 80; i++) {
+            uint32_t x = w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16];
+            w[i] = (x << 1) | (x >> 31);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+
+            uint32_t t = ((a << 5) | (a >> 27)) + f + e + k + w[i];
+            e = d; d = c; c = (b << 30) | (b >> 2); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+    free(msg);
+
+    for (int i = 0; i < 20; i++) digest[i] = (unsigned char)(h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+void Base64(const unsigned char* in, int len, char* out) {
+    const char* tbl = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    int o = 0;
+
+    for (int i = 0; i < len; i += 3) {
+        uint32_t v = in[i] << 16 | (i + 1 < len ? in[i + 1] << 8 : 0) | (i + 2 < len ? in[i + 2] : 0);
+        out[o++] = tbl[(v >> 18) & 63];
+        out[o++] = tbl[(v >> 12) & 63];
+        out[o++] = (i + 1 < len) ? tbl[(v >> 6) & 63] : '=';
+        out[o++] = (i + 2 < len) ? tbl[v & 63] : '=';
+    }
+    out[o] = '\0';
+}
+
+/**
+ * @brief Closes a viewer and removes it from the fan-out list
+ * The struct stays allocated until the end of the epoll batch, so later
+ * events of the same batch can see fd == -1 and skip it
+ */
+void DropViewer(Viewer* v) {
+    epoll_ctl(broadcastEpollFd, EPOLL_CTL_DEL, v->fd, NULL);
+    close(v->fd);
+    v->fd = -1;
+
+    viewers[v->index] = viewers[--viewerCount];
+    viewers[v->index]->index = v->index;
+
+    if (deadCount == deadCapacity) {
+        deadCapacity = (deadCapacity == 0) ? 64 : deadCapacity * 2;
+        deadViewers = realloc(deadViewers, sizeof(Viewer*) * deadCapacity);
+    }
+    deadViewers[deadCount++] = v;
+}
+
+void FreeDeadViewers() {
+    for (int i = 0; i < deadCount; i++) {
+        free(deadViewers[i]->out);
+        free(deadViewers[i]);
+    }
+    deadCount = 0;
+}
+
+/**
+ * @brief Writes as much of the backlog as the socket takes
+ * Switches EPOLLOUT on while bytes remain and off once drained
+ *
+ * @return false if the viewer was dropped
+ */
+bool FlushViewer(Viewer* v) {
+    while (v->outHead < v->outLen) {
+        ssize_t n = send(v->fd, v->out + v->outHead, v->outLen - v->outHead, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            DropViewer(v);
+            return false;
+        }
+        v->outHead += n;
+        broadcastBytesSent += n;
+    }
+
+    if (v->outHead == v->outLen) v->outHead = v->outLen = 0;
+
+    bool pending = v->outLen > 0;
+    if (pending != v->wantWrite) {
+        struct epoll_event ev = { .events = EPOLLIN | (pending ? EPOLLOUT : 0), .data.ptr = v };
+        epoll_ctl(broadcastEpollFd, EPOLL_CTL_MOD, v->fd, &ev);
+        v->wantWrite = pending;
+    }
+    return true;
+}
+
+/**
+ * @brief Appends one framed message to a viewer's backlog
+ *
+ * @return false if the viewer is too far behind and was dropped
+ */
+bool QueueForViewer(Viewer* v, const unsigned char* data, int len) {
+    size_t need = len + 2;
+
+    if (v->outLen - v->outHead + need > VIEWER_OUT_LIMIT) {
+        broadcastDropped++;
+        DropViewer(v);
+        return false;
+    }
+
+    if (v->outLen + need > v->outCap) {
+        // slide the unsent part to the front before growing
+        memmove(v->out, v->out + v->outHead, v->outLen - v->outHead);
+        v->outLen -= v->outHead;
+        v->outHead = 0;
+        if (v->outLen + need > v->outCap) {
+            v->outCap = (v->outCap == 0) ? 1024 : v->outCap * 2;
+            while (v->outCap < v->outLen + need) v->outCap *= 2;
+            v->out = realloc(v->out, v->outCap);
+        }
+    }
+
+    v->out[v->outLen++] = (v->state == VIEWER_WEBSOCKET) ? 0x82 : (unsigned char)len;
+    if (v->state == VIEWER_WEBSOCKET) v->out[v->outLen++] = (unsigned char)len;
+    memcpy(v->out + v->outLen, data, len);
+    v->outLen += len;
+    return true;
+}
+
+/**
+ * @brief Completes the handshake once the request is in, then sends the snapshot
+ *
+ * @return false if the viewer was dropped
+ */
+bool HandshakeViewer(Viewer* v) {
+    v->in[v->inLen] = '\0';
+
+    if (strncmp(v->in, "CHESS\n", 6) == 0) {
+        v->state = VIEWER_RAW;
+    } else if (strncmp(v->in, "GET ", 4) == 0) {
+        if (strstr(v->in, "\r\n\r\n") == NULL) return true;
+
+        const char* key = NULL;
+        for (char* line = v->in; line != NULL; line = strstr(line, "\r\n")) {
+            while (*line == '\r' || *line == '\n') line++;
+            if (strncasecmp(line, "Sec-WebSocket-Key:", 18) == 0) { key = line + 18; break; }
+        }
+        if (key == NULL) {
+            DropViewer(v);
+            return false;
+        }
+
+        while (*key == ' ') key++;
+        char accept[128];
+        int keyLen = (int)strcspn(key, "\r\n ");
+        if (keyLen > 64) keyLen = 64;
+        sprintf(accept, "%.*s258EAFA5-E914-47DA-95CA-C5AB0DC85B11", keyLen, key);
+
+        unsigned char digest[20];
+        char acceptB64[32];
+        Sha1((unsigned char*)accept, strlen(accept), digest);
+        Base64(digest, 20, acceptB64);
+
+        char response[256];
+        int n = sprintf(response,
+            "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+            "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n", acceptB64);
+        if (send(v->fd, response, n, MSG_NOSIGNAL) != n) {
+            DropViewer(v);
+            return false;
+        }
+        v->state = VIEWER_WEBSOCKET;
+    } else if (v->inLen >= 6 || strchr(v->in, '\n') != NULL) {
+        DropViewer(v);
+        return false;
+    } else {
+        return true;
+    }
+
+    v->inLen = 0;
+
+    pthread_mutex_lock(&broadcastMutex);
+    BroadcastMessage snap = broadcastSnapshot;
+    pthread_mutex_unlock(&broadcastMutex);
+
+    v->seqFloor = snap.seq;
+    return QueueForViewer(v, snap.data, snap.len) && FlushViewer(v);
+}
+
+/**
+ * @brief Reads from a viewer: the handshake, afterwards input is discarded
+ */
+void ReadViewer(Viewer* v) {
+    for (;;) {
+        char scratch[512];
+        bool handshaking = v->state == VIEWER_HANDSHAKE;
+        char* dst = handshaking ? v->in + v->inLen : scratch;
+        int room = handshaking ? VIEWER_IN_SIZE - 1 - v->inLen : (int)sizeof(scratch);
+
+        if (room <= 0) {
+            DropViewer(v);
+            return;
+        }
+
+        ssize_t n = recv(v->fd, dst, room, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            DropViewer(v);
+            return;
+        }
+        if (n < 0) return;
+
+        if (handshaking) {
+            v->inLen += n;
+            if (!HandshakeViewer(v)) return;
+        }
+    }
+}
+
+void AcceptViewers() {
+    for (;;) {
+        int fd = accept(broadcastListenFd, NULL, NULL);
+        if (fd < 0) return;
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        Viewer* v = calloc(1, sizeof(Viewer));
+        v->fd = fd;
+        v->state = VIEWER_HANDSHAKE;
+
+        if (viewerCount == viewerCapacity) {
+            viewerCapacity = (viewerCapacity == 0) ? 256 : viewerCapacity * 2;
+            viewers = realloc(viewers, sizeof(Viewer*) * viewerCapacity);
+        }
+        v->index = viewerCount;
+        viewers[viewerCount++] = v;
+
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = v };
+        epoll_ctl(broadcastEpollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+/**
+ * @brief Takes the queued messages and fans them out to every viewer
+ */
+void FanOut() {
+    static BroadcastMessage pending[BROADCAST_QUEUE_SIZE];
+    uint64_t counter;
+    if (read(broadcastWakeFd, &counter, sizeof(counter)) < 0) { /* nothing to drain */ }
+
+    pthread_mutex_lock(&broadcastMutex);
+    int count = broadcastQueueCount;
+    for (int i = 0; i < count; i++)
+        pending[i] = broadcastQueue[(broadcastQueueHead + i) % BROADCAST_QUEUE_SIZE];
+    broadcastQueueHead = broadcastQueueCount = 0;
+
+    bool resync = broadcastOverflow;
+    BroadcastMessage snap = broadcastSnapshot;
+    broadcastOverflow = false;
+    pthread_mutex_unlock(&broadcastMutex);
+
+    // iterate backwards, DropViewer swaps the last viewer into the freed slot
+    for (int i = viewerCount - 1; i >= 0; i--) {
+        Viewer* v = viewers[i];
+        if (v->state == VIEWER_HANDSHAKE) continue;
+
+        if (resync) {
+            v->seqFloor = snap.seq;
+            if (!QueueForViewer(v, snap.data, snap.len)) continue;
+        } else {
+            bool alive = true;
+            for (int m = 0; m < count && alive; m++) {
+                if (pending[m].seq <= v->seqFloor) continue;
+                alive = QueueForViewer(v, pending[m].data, pending[m].len);
+            }
+            if (!alive) continue;
+        }
+        FlushViewer(v);
+    }
+}
+
+void* BroadcastWorker(void* arg) {
+    (void)arg;
+    struct epoll_event events[256];
+    static int listenTag, wakeTag;
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &listenTag };
+    epoll_ctl(broadcastEpollFd, EPOLL_CTL_ADD, broadcastListenFd, &ev);
+    ev.data.ptr = &wakeTag;
+    epoll_ctl(broadcastEpollFd, EPOLL_CTL_ADD, broadcastWakeFd, &ev);
+
+    while (!broadcastStopping) {
+        int n = epoll_wait(broadcastEpollFd, events, 256, -1);
+
+        for (int i = 0; i < n; i++) {
+            void* tag = events[i].data.ptr;
+
+            if (tag == &listenTag) {
+                AcceptViewers();
+            } else if (tag == &wakeTag) {
+                FanOut();
+            } else {
+                Viewer* v = tag;
+                if (v->fd < 0) continue;
+
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    DropViewer(v);
+                    continue;
+                }
+                if ((events[i].events & EPOLLOUT) && !FlushViewer(v)) continue;
+                if (events[i].events & EPOLLIN) ReadViewer(v);
+            }
+        }
+        FreeDeadViewers();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Opens the listening socket and starts the network thread
+ */
+bool BroadcastStart(int port) {
+    broadcastListenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (broadcastListenFd < 0) return false;
+
+    int one = 1;
+    setsockopt(broadcastListenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(broadcastListenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(broadcastListenFd, SOMAXCONN) < 0) {
+        TraceLog(LOG_WARNING, "BROADCAST: could not listen on port %d", port);
+        close(broadcastListenFd);
+        broadcastListenFd = -1;
+        return false;
+    }
+    fcntl(broadcastListenFd, F_SETFL, fcntl(broadcastListenFd, F_GETFL) | O_NONBLOCK);
+
+    broadcastWakeFd = eventfd(0, EFD_NONBLOCK);
+    broadcastEpollFd = epoll_create1(0);
+
+    // seed the snapshot, first delta is computed against the current board
+    memcpy(broadcastBoard, board, sizeof(board));
+    broadcastTurn = turn;
+    broadcastSnapshot.len = EncodeSnapshot(broadcastSnapshot.data, broadcastSeq, NowMicros());
+    broadcastSnapshot.seq = broadcastSeq;
+
+    broadcastStopping = false;
+    if (pthread_create(&broadcastThread, NULL, BroadcastWorker, NULL) != 0) {
+        close(broadcastListenFd);
+        close(broadcastWakeFd);
+        close(broadcastEpollFd);
+        broadcastListenFd = -1;
+        return false;
+    }
+
+    broadcastRunning = true;
+    TraceLog(LOG_INFO, "BROADCAST: serving spectators on port %d", port);
+    return true;
+}
+
+/**
+ * @brief Stops the network thread and disconnects every viewer
+ */
+void BroadcastStop() {
+    if (!broadcastRunning) return;
+
+    broadcastRunning = false;
+    broadcastStopping = true;
+    uint64_t one = 1;
+    if (write(broadcastWakeFd, &one, sizeof(one)) < 0) { /* thread is awake anyway */ }
+    pthread_join(broadcastThread, NULL);
+
+    while (viewerCount > 0) DropViewer(viewers[viewerCount - 1]);
+    FreeDeadViewers();
+    free(viewers);
+    free(deadViewers);
+    viewers = deadViewers = NULL;
+    viewerCapacity = deadCapacity = 0;
+
+    close(broadcastListenFd);
+    close(broadcastWakeFd);
+    close(broadcastEpollFd);
+    broadcastListenFd = broadcastWakeFd = broadcastEpollFd = -1;
+}
+
+//===========================================================================
+// BROADCAST LOAD TEST
+//===========================================================================
+
+/**
+ * LoadViewer struct: one simulated spectator on the load-test side
+ */
+typedef struct LoadViewer{
+    int fd;
+    unsigned char buf[4096];
+    int len;
+} LoadViewer;
+
+volatile bool loadStopping = false;
+int loadEpollFd = -1;
+uint32_t* loadLatencies = NULL;     // microseconds, one per delivered message
+long loadLatencyCount = 0;
+long loadLatencyCapacity = 0;
+long long loadBytes = 0;
+long loadDisconnects = 0;
+
+/**
+ * @brief Load-test receiver: parses raw frames and records fan-out latency
+ */
+void* LoadReceiver(void* arg) {
+    (void)arg;
+    struct epoll_event events[512];
+
+    while (!loadStopping) {
+        int n = epoll_wait(loadEpollFd, events, 512, 50);
+
+        for (int i = 0; i < n; i++) {
+            LoadViewer* lv = events[i].data.ptr;
+
+            for (;;) {
+                ssize_t got = recv(lv->fd, lv->buf + lv->len, sizeof(lv->buf) - lv->len, 0);
+                if (got <= 0) {
+                    if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                        epoll_ctl(loadEpollFd, EPOLL_CTL_DEL, lv->fd, NULL);
+                        loadDisconnects++;
+                    }
+                    break;
+                }
+                uint64_t now = NowMicros();
+                loadBytes += got;
+                lv->len += got;
+
+                int off = 0;
+                while (off < lv->len && off + 1 + lv->buf[off] <= lv->len) {
+                    const unsigned char* msg = lv->buf + off + 1;
+                    off += 1 + lv->buf[off];
+
+                    // the connect-time snapshot predates the test
+                    if (GetU32(msg + 1) == 0) continue;
+
+                    if (loadLatencyCount == loadLatencyCapacity) {
+                        loadLatencyCapacity = (loadLatencyCapacity == 0) ? 65536 : loadLatencyCapacity * 2;
+                        loadLatencies = realloc(loadLatencies, sizeof(uint32_t) * loadLatencyCapacity);
+                    }
+                    loadLatencies[loadLatencyCount++] = (uint32_t)(now - GetU64(msg + 5));
+                }
+                memmove(lv->buf, lv->buf + off, lv->len - off);
+                lv->len -= off;
+            }
+        }
+    }
+    return NULL;
+}
+
+int CompareU32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Headless load test: serves on localhost, connects many raw viewers,
+ * plays random games at 20 moves per second and reports fan-out latency
+ * (emit on the game side to receipt by the viewer) and bandwidth.
+ *
+ * @return process exit code
+ */
+int RunLoadTest(int viewerTotal, int seconds, int port) {
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    InitBoard();
+    turn = WHITE_PIECE;
+    if (!BroadcastStart(port)) return 1;
+
+    loadEpollFd = epoll_create1(0);
+    LoadViewer* lvs = calloc(viewerTotal, sizeof(LoadViewer));
+    int connected = 0;
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (int i = 0; i < viewerTotal; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+            send(fd, "CHESS\n", 6, MSG_NOSIGNAL) != 6) {
+            if (fd >= 0) close(fd);
+            TraceLog(LOG_WARNING, "LOADTEST: only %d of %d viewers connected", connected, viewerTotal);
+            break;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        lvs[connected].fd = fd;
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &lvs[connected] };
+        epoll_ctl(loadEpollFd, EPOLL_CTL_ADD, fd, &ev);
+        connected++;
+    }
+
+    pthread_t receiver;
+    pthread_create(&receiver, NULL, LoadReceiver, NULL);
+
+    // give the server time to finish the handshakes before measuring
+    struct timespec settle = { 1, 0 };
+    nanosleep(&settle, NULL);
+
+    long emitted = 0;
+    int lastMove[4];
+    uint64_t start = NowMicros();
+    uint64_t end = start + (uint64_t)seconds * 1000000u;
+
+    while (NowMicros() < end) {
+        if (gameOver || !PlayRandomMove(lastMove)) {
+            RestartGame();
+        } else {
+            turn = (turn == WHITE_PIECE) ? BLACK_PIECE : WHITE_PIECE;
+            BroadcastSync();
+            if (!HasAnyValidMove(turn)) gameOver = true;
+        }
+        emitted++;
+
+        struct timespec tick = { 0, 50 * 1000000 };
+        nanosleep(&tick, NULL);
+    }
+    double elapsed = (NowMicros() - start) / 1e6;
+
+    // let the last messages drain
+    struct timespec drain = { 0, 500 * 1000000 };
+    nanosleep(&drain, NULL);
+    loadStopping = true;
+    pthread_join(receiver, NULL);
+
+    BroadcastStop();
+    long dropped = broadcastDropped;
+    long long sent = broadcastBytesSent;    // network thread has exited, safe to read
+
+    long samples = loadLatencyCount;
+    uint32_t* lat = loadLatencies;
+    qsort(lat, samples, sizeof(uint32_t), CompareU32);
+
+    printf("loadtest: %d viewers connected, %ld dropped as slow, %ld closed\n", connected, dropped, loadDisconnects);
+    printf("messages: %ld emitted in %.1f s, %ld delivered (%.1f%% of %ld expected)\n",
+           emitted, elapsed, samples, 100.0 * samples / ((double)emitted * connected + 1e-9),
+           emitted * connected);
+    if (samples > 0) {
+        printf("fan-out latency us: p50 %u  p95 %u  p99 %u  max %u\n",
+               lat[samples / 2], lat[samples * 95 / 100], lat[samples * 99 / 100], lat[samples - 1]);
+    }
+    printf("bandwidth: %.2f MB total, %.2f MB/s, %.1f bytes per delivered message\n",
+           loadBytes / 1e6, loadBytes / 1e6 / elapsed, (double)loadBytes / (samples ? samples : 1));
+    printf("server side: %.2f MB sent, %lld bytes not received\n", sent / 1e6, sent - loadBytes);
+
+    for (int i = 0; i < connected; i++) close(lvs[i].fd);
+    close(loadEpollFd);
+    free(lvs);
+    free(loadLatencies);
+    return 0;
+}
+
+#else
+
+bool BroadcastStart(int port) {
+    TraceLog(LOG_WARNING, "BROADCAST: spectator server needs epoll, not available on this platform");
+    return false;
+}
+
+void BroadcastSync() {}
+
+void BroadcastStop() {}
+
+int RunLoadTest(int viewers, int seconds, int port) {
+    TraceLog(LOG_WARNING, "LOADTEST: spectator server needs epoll, not available on this platform");
+    return 1;
+}
+
+#endif
+
+//===========================================================================
+// ANALYSIS ENGINE
+//===========================================================================
+
+/*
+ * Small alpha-beta searcher on top of the rules functions, used by the
+ * headless tools. Positions are made and unmade by copying GameState, so
+ * the rules code stays the single source of truth for legality.
+ */
+
+#define MAX_MOVES 256
+#define MATE_SCORE 100000
+#define MATE_BOUND (MATE_SCORE - 1000)     // scores beyond this are mate in N
+#define MAX_SEARCH_DEPTH 32
+#define QUIESCE_DEPTH 4
+
+/**
+ * Move struct: one legal move
+ * PieceType promotion: EMPTY unless a pawn reaches the last rank
+ */
+typedef struct Move{
+    signed char sr;
+    signed char sc;
+    signed char dr;
+    signed char dc;
+    PieceType promotion;
+} Move;
+
+/**
+ * SearchContext struct: budget and bookkeeping of one search
+ * A zero nodeLimit or deadline means no limit of that kind
+ */
+typedef struct SearchContext{
+    long nodes;
+    long nodeLimit;
+    uint64_t deadline;
+    bool canAbort;
+    bool aborted;
+} SearchContext;
+
+// indexed by PieceType
+const int pieceValue[7] = { 0, 100, 500, 320, 330, 900, 0 };
+const char pieceLetter[7] = { ' ', 'P', 'R', 'N', 'B', 'Q', 'K' };
+
+// Zobrist keys, filled once by InitZobrist before any worker starts
+uint64_t zobristPiece[64][14];
+uint64_t zobristUnmoved[64];
+uint64_t zobristEnPassant[8];
+uint64_t zobristSide;
+bool zobristReady = false;
+
+uint64_t SplitMix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void InitZobrist() {
+    if (zobristReady) return;
+
+    uint64_t seed = 0x0C4E55u;
+    for (int sq = 0; sq < 64; sq++) {
+        for (int k = 0; k < 14; k++) zobristPiece[sq][k] = SplitMix64(&seed);
+        zobristUnmoved[sq] = SplitMix64(&seed);
+    }
+    for (int c = 0; c < 8; c++) zobristEnPassant[c] = SplitMix64(&seed);
+    zobristSide = SplitMix64(&seed);
+    zobristReady = true;
+}
+
+/**
+ * @brief Hash of the current position
+ * Covers pieces, side to move, castling (unmoved kings and rooks) and
+ * the en passant file
+ */
+uint64_t HashPosition() {
+    uint64_t h = 0;
+
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            Piece p = board[r][c];
+            if (p.type == EMPTY) continue;
+
+            h ^= zobristPiece[r * 8 + c][(p.type - 1) + 7 * p.color];
+            if (!p.moved && (p.type == KING || p.type == ROOK)) h ^= zobristUnmoved[r * 8 + c];
+        }
+    }
+    if (enPassantTargetCol != -1) h ^= zobristEnPassant[enPassantTargetCol];
+    if (turn == BLACK_PIECE) h ^= zobristSide;
+    return h;
+}
+
+void AddMove(Move* moves, int* count, int sr, int sc, int dr, int dc) {
+    if (!IsValidMove(sr, sc, dr, dc) || TestMoveForCheck(turn, sr, sc, dr, dc)) return;
+
+    Move m = { sr, sc, dr, dc, EMPTY };
+
+    if (board[sr][sc].type == PAWN && (dr == 0 || dr == 7)) {
+        const PieceType options[4] = { QUEEN, ROOK, BISHOP, KNIGHT };
+        for (int i = 0; i < 4; i++) {
+            m.promotion = options[i];
+            moves[(*count)++] = m;
+        }
+        return;
+    }
+    moves[(*count)++] = m;
+}
+
+/**
+ * @brief Lists every legal move for the side to move
+ * Only squares a piece of that type could reach are offered to
+ * IsValidMove, which stays the judge of legality.
+ *
+ * @return number of moves written (at most MAX_MOVES)
+ */
+int GenerateLegalMoves(Move* moves) {
+    static const int knight[8][2] = { {-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1} };
+    static const int around[8][2] = { {-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1} };
+    int count = 0;
+
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            Piece p = board[r][c];
+            if (p.type == EMPTY || p.color != turn) continue;
+
+            switch (p.type) {
+                case PAWN: {
+                    int dir = (p.color == WHITE_PIECE) ? -1 : 1;
+                    AddMove(moves, &count, r, c, r + dir, c);
+                    AddMove(moves, &count, r, c, r + 2 * dir, c);
+                    AddMove(moves, &count, r, c, r + dir, c - 1);
+                    AddMove(moves, &count, r, c, r + dir, c + 1);
+                    break;
+                }
+                case KNIGHT:
+                    for (int i = 0; i < 8; i++) AddMove(moves, &count, r, c, r + knight[i][0], c + knight[i][1]);
+                    break;
+                case KING:
+                    for (int i = 0; i < 8; i++) AddMove(moves, &count, r, c, r + around[i][0], c + around[i][1]);
+                    AddMove(moves, &count, r, c, r, c + 2);
+                    AddMove(moves, &count, r, c, r, c - 2);
+                    break;
+                default:
+                    // sliders: walk each ray up to and including the first blocker
+                    for (int i = 0; i < 8; i++) {
+                        bool diagonal = around[i][0] != 0 && around[i][1] != 0;
+                        if ((p.type == ROOK && diagonal) || (p.type == BISHOP && !diagonal)) continue;
+
+                        for (int dr = r + around[i][0], dc = c + around[i][1];
+                             dr >= 0 && dr < 8 && dc >= 0 && dc < 8;
+                             dr += around[i][0], dc += around[i][1]) {
+                            AddMove(moves, &count, r, c, dr, dc);
+                            if (board[dr][dc].type != EMPTY) break;
+                        }
+                    }
+                    break;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Plays a legal move on the rules globals and passes the turn
+ */
+void MakeMove(Move m) {
+    MovePiece(m.sr, m.sc, m.dr, m.dc);
+
+    if (promotionActive) {
+        board[promotionRow][promotionCol].type = (m.promotion != EMPTY) ? m.promotion : QUEEN;
+        promotionActive = false;
+    }
+    turn = (turn == WHITE_PIECE) ? BLACK_PIECE : WHITE_PIECE;
+}
+
+bool IsCapture(Move m) {
+    return board[m.dr][m.dc].type != EMPTY ||
+           (board[m.sr][m.sc].type == PAWN && m.dr == enPassantTargetRow && m.dc == enPassantTargetCol);
+}
+
+bool SameMove(Move a, Move b) {
+    return a.sr == b.sr && a.sc == b.sc && a.dr == b.dr && a.dc == b.dc && a.promotion == b.promotion;
+}
+
+/**
+ * @brief Writes a move in standard algebraic notation (e.g. "Nbd7", "exd8=Q+")
+ * Must be called on the position before the move
+ */
+void MoveToSan(Move m, char* out) {
+    Piece p = board[m.sr][m.sc];
+    char* o = out;
+
+    if (p.type == KING && abs(m.dc - m.sc) == 2) {
+        o += sprintf(o, (m.dc > m.sc) ? "O-O" : "O-O-O");
+    } else {
+        bool capture = IsCapture(m);
+
+        if (p.type == PAWN) {
+            if (capture) *o++ = 'a' + m.sc;
+        } else {
+            *o++ = pieceLetter[p.type];
+
+            // disambiguate against other pieces of the same kind reaching the square
+            Move moves[MAX_MOVES];
+            int count = GenerateLegalMoves(moves);
+            bool clash = false, sameFile = false, sameRank = false;
+            for (int i = 0; i < count; i++) {
+                Move o2 = moves[i];
+                if (o2.dr != m.dr || o2.dc != m.dc || (o2.sr == m.sr && o2.sc == m.sc)) continue;
+                if (board[o2.sr][o2.sc].type != p.type) continue;
+                clash = true;
+                sameFile |= o2.sc == m.sc;
+                sameRank |= o2.sr == m.sr;
+            }
+            if (clash && (!sameFile || sameRank)) *o++ = 'a' + m.sc;
+            if (clash && sameFile) *o++ = '1' + (7 - m.sr);
+        }
+
+        if (capture) *o++ = 'x';
+        *o++ = 'a' + m.dc;
+        *o++ = '1' + (7 - m.dr);
+        if (m.promotion != EMPTY) {
+            *o++ = '=';
+            *o++ = pieceLetter[m.promotion];
+        }
+    }
+
+    GameState saved;
+    SaveGameState(&saved);
+    MakeMove(m);
+    if (IsInCheck(turn)) *o++ = HasAnyValidMove(turn) ? '+' : '#';
+    LoadGameState(&saved);
+
+    *o = '\0';
+}
+
+/**
+ * @brief Finds the legal move a SAN token stands for
+ * Accepts the usual variations: check/annotation suffixes, "0-0", missing '='
+ *
+ * @return false if no legal move (or more than one) matches
+ */
+bool ParseSan(const char* san, Move* out) {
+    char s[16];
+    int len = 0;
+    for (const char* i = san; *i != '\0' && len < 15; i++)
+        if (strchr("+#!?", *i) == NULL) s[len++] = *i;
+    s[len] = '\0';
+
+    Move moves[MAX_MOVES];
+    int count = GenerateLegalMoves(moves);
+
+    if (strcmp(s, "O-O") == 0 || strcmp(s, "0-0") == 0 || strcmp(s, "O-O-O") == 0 || strcmp(s, "0-0-0") == 0) {
+        int dir = (len == 3) ? 1 : -1;
+        for (int i = 0; i < count; i++) {
+            if (board[moves[i].sr][moves[i].sc].type == KING && moves[i].dc - moves[i].sc == 2 * dir) {
+                *out = moves[i];
+                return true;
+            }
         }
+        return false;
+    }
 
-        case ROOK:
-            return (sr == dr || sc == dc) && IsPathClear(sr, sc, dr, dc);
+    PieceType type = PAWN;
+    int start = 0;
+    for (int t = ROOK; t <= KING; t++)
+        if (s[0] == pieceLetter[t]) { type = t; start = 1; }
+
+    PieceType promotion = EMPTY;
+    char* eq = strchr(s, '=');
+    if (eq != NULL || (type == PAWN && len > 0 && strchr("QRBN", s[len - 1]) != NULL)) {
+        char letter = (eq != NULL) ? eq[1] : s[len - 1];
+        for (int t = ROOK; t <= QUEEN; t++) if (letter == pieceLetter[t]) promotion = t;
+        len = (eq != NULL) ? (int)(eq - s) : len - 1;
+    }
+    if (len - start < 2) return false;
+
+    int dc = s[len - 2] - 'a';
+    int dr = 7 - (s[len - 1] - '1');
+    int fromFile = -1, fromRank = -1;
+    for (int i = start; i < len - 2; i++) {
+        if (s[i] >= 'a' && s[i] <= 'h') fromFile = s[i] - 'a';
+        else if (s[i] >= '1' && s[i] <= '8') fromRank = 7 - (s[i] - '1');
+    }
 
-        case KNIGHT:
-            return (abs(rDiff) == 2 && abs(cDiff) == 1) || (abs(rDiff) == 1 && abs(cDiff) == 2);
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        Move m = moves[i];
+        if (m.dr != dr || m.dc != dc || board[m.sr][m.sc].type != type) continue;
+        if (fromFile != -1 && m.sc != fromFile) continue;
+        if (fromRank != -1 && m.sr != fromRank) continue;
+        if (m.promotion != EMPTY && m.promotion != (promotion != EMPTY ? promotion : QUEEN)) continue;
 
-        case BISHOP:
-            return (abs(rDiff) == abs(cDiff)) && IsPathClear(sr, sc, dr, dc);
+        *out = m;
+        found++;
+    }
+    return found == 1;
+}
 
-        case QUEEN:
-            return (sr == dr || sc == dc || abs(rDiff) == abs(cDiff)) && IsPathClear(sr, sc, dr, dc);
+/**
+ * @brief Static evaluation from the side to move's point of view
+ * Material, pawn advancement and a small centralization bonus for minors
+ */
+int Evaluate() {
+    int score = 0;
 
-        case KING:{
-            if(abs(rDiff) <= 1 && abs(cDiff) <= 1) return true;
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            Piece p = board[r][c];
+            if (p.type == EMPTY) continue;
 
-            if(!p.moved && rDiff == 0 && abs(cDiff) == 2){
-                int rookCol = (cDiff > 0) ? 7 : 0;
+            int v = pieceValue[p.type];
+            if (p.type == PAWN) v += 5 * ((p.color == WHITE_PIECE) ? 6 - r : r - 1);
+            if (p.type == KNIGHT || p.type == BISHOP)
+                v += 10 - 3 * (abs(2 * r - 7) + abs(2 * c - 7)) / 2;
 
-                // Castling conditions:
-                // 1. Rook hasn't moved
-                // 2. Path is clear
-                // 3. King not currently in check
-                // 4. King doesn't pass through attacked squares
-                if (board[sr][rookCol].type == ROOK && !board[sr][rookCol].moved && IsPathClear(sr, sc, sr, rookCol)){
+            score += (p.color == WHITE_PIECE) ? v : -v;
+        }
+    }
+    return (turn == WHITE_PIECE) ? score : -score;
+}
 
-                    if (IsInCheck(p.color)) return false;
+bool SearchShouldStop(SearchContext* ctx) {
+    if (ctx->aborted) return true;
+    if (!ctx->canAbort) return false;
 
-                    return !TestMoveForCheck(p.color, sr, sc, sr, sc + (cDiff > 0 ? 1 : -1));
-                }
-            }
-            return false;
+    if (ctx->nodeLimit > 0 && ctx->nodes >= ctx->nodeLimit) ctx->aborted = true;
+    if (ctx->deadline > 0 && (ctx->nodes & 63) == 0 && NowMicros() >= ctx->deadline) ctx->aborted = true;
+    return ctx->aborted;
+}
+
+/**
+ * @brief Orders captures first, most valuable victim by least valuable attacker
+ */
+void OrderMoves(Move* moves, int count, const Move* first) {
+    int keys[MAX_MOVES];
+
+    for (int i = 0; i < count; i++) {
+        Move m = moves[i];
+        keys[i] = IsCapture(m) ? 10 * pieceValue[board[m.dr][m.dc].type] - pieceValue[board[m.sr][m.sc].type] + 1000 : 0;
+        if (m.promotion != EMPTY) keys[i] += pieceValue[m.promotion];
+        if (first != NULL && SameMove(m, *first)) keys[i] = 1 << 30;
+    }
+
+    // insertion sort, move lists are short
+    for (int i = 1; i < count; i++) {
+        Move m = moves[i];
+        int k = keys[i], j = i - 1;
+        for (; j >= 0 && keys[j] < k; j--) {
+            moves[j + 1] = moves[j];
+            keys[j + 1] = keys[j];
         }
+        moves[j + 1] = m;
+        keys[j + 1] = k;
+    }
+}
 
-        default:
-            return false;
+int Quiesce(SearchContext* ctx, int alpha, int beta, int depth, int ply) {
+    ctx->nodes++;
+    if (SearchShouldStop(ctx)) return 0;
+
+    Move moves[MAX_MOVES];
+    int count = GenerateLegalMoves(moves);
+    if (count == 0) return IsInCheck(turn) ? -MATE_SCORE + ply : 0;
+
+    int standPat = Evaluate();
+    if (depth == 0 || standPat >= beta) return standPat;
+    if (standPat > alpha) alpha = standPat;
+
+    OrderMoves(moves, count, NULL);
+
+    for (int i = 0; i < count && IsCapture(moves[i]); i++) {
+        GameState saved;
+        SaveGameState(&saved);
+        MakeMove(moves[i]);
+        int score = -Quiesce(ctx, -beta, -alpha, depth - 1, ply + 1);
+        LoadGameState(&saved);
+
+        if (ctx->aborted) return 0;
+        if (score >= beta) return score;
+        if (score > alpha) alpha = score;
     }
+    return alpha;
+}
+
+int Negamax(SearchContext* ctx, int depth, int alpha, int beta, int ply, Move* best) {
+    if (depth == 0) return Quiesce(ctx, alpha, beta, QUIESCE_DEPTH, ply);
+
+    ctx->nodes++;
+    if (SearchShouldStop(ctx)) return 0;
+
+    Move moves[MAX_MOVES];
+    int count = GenerateLegalMoves(moves);
+    if (count == 0) return IsInCheck(turn) ? -MATE_SCORE + ply : 0;
+
+    OrderMoves(moves, count, best);
+    int bestScore = -MATE_SCORE - 1;
+
+    for (int i = 0; i < count; i++) {
+        GameState saved;
+        SaveGameState(&saved);
+        MakeMove(moves[i]);
+        int score = -Negamax(ctx, depth - 1, -beta, -alpha, ply + 1, NULL);
+        LoadGameState(&saved);
+
+        if (ctx->aborted) return 0;
+        if (score > bestScore) {
+            bestScore = score;
+            if (best != NULL) *best = moves[i];
+        }
+        if (score > alpha) alpha = score;
+        if (alpha >= beta) break;
+    }
+    return bestScore;
 }
 
 /**
- * @brief Executes a move with all side effects
- * Performs safety check, handles special moves, updates board states
+ * @brief Iterative deepening on the current position within the budget
+ * Depth 1 always completes, later iterations are dropped if cut off
  *
- * @param sr Source Row
- * @param sc Source Column
- * @param dr Destination Row
- * @param dc Destination Column
+ * @param best Receives the best move, left untouched if there is none
+ * @param depthOut Receives the last completed depth
  *
- * @returns true if move was successfully executed
+ * @return score in centipawns for the side to move (±MATE_SCORE - plies for mates)
  */
-bool MovePiece(int sr, int sc, int dr, int dc) {
-    // ========================================================================
-    // PRE-MOVE VALIDATION
-    // ========================================================================
-    if (!IsValidMove(sr, sc, dr, dc)) return false;
+int SearchPosition(SearchContext* ctx, Move* best, int* depthOut) {
+    Move moves[MAX_MOVES];
+    if (GenerateLegalMoves(moves) == 0) {
+        *depthOut = 0;
+        return IsInCheck(turn) ? -MATE_SCORE : 0;
+    }
 
-    Piece p = board[sr][sc];
+    int score = 0;
+    Move iterBest = moves[0];
+    for (int depth = 1; depth <= MAX_SEARCH_DEPTH; depth++) {
+        ctx->canAbort = depth > 1;
+        Move candidate = iterBest;
+        int s = Negamax(ctx, depth, -MATE_SCORE - 1, MATE_SCORE + 1, 0, &candidate);
+        if (ctx->aborted) break;
+
+        score = s;
+        iterBest = candidate;
+        *depthOut = depth;
+        if (abs(score) > MATE_BOUND) break;
+    }
 
-    if (TestMoveForCheck(p.color, sr, sc, dr, dc)) return false;
+    *best = iterBest;
+    return score;
+}
 
-    // ========================================================================
-    // EN PASSANT CAPTURE HANDLING
-    // ========================================================================
-    bool isEnPassantCapture = (p.type == PAWN && dr == enPassantTargetRow && dc == enPassantTargetCol && p.color != enPassantPawnColor);
+//===========================================================================
+// PGN ANNOTATION
+//===========================================================================
 
-    if (isEnPassantCapture) {
-        int captureRow = (p.color == WHITE_PIECE) ? dr + 1 : dr - 1;
-        board[captureRow][dc] = (Piece){EMPTY, NONE_PIECE, false, false};
+/*
+ * Headless batch annotation: --annotate in.pgn out.pgn [--nodes N]
+ * [--movetime ms] [--threads N]
+ *
+ * Every game is replayed with the rules code while parsing. Each distinct
+ * position (by Zobrist key) becomes one entry in the analysis cache, so a
+ * position seen in many games is analysed once. The entries are dealt
+ * round-robin onto per-worker deques; a worker pops from its own bottom
+ * and steals from the top of the others, so one long game cannot leave
+ * cores idle.
+ */
+
+#define ANNOTATE_DEFAULT_NODES 20000
+#define INACCURACY_LOSS 50
+#define MISTAKE_LOSS 100
+#define BLUNDER_LOSS 300
+#define PGN_LINE_WIDTH 79
+
+/**
+ * AnalysisEntry struct: one distinct position and, once analysed, its result
+ * score is from the side to move's point of view
+ */
+typedef struct AnalysisEntry{
+    uint64_t key;
+    bool used;
+    GameState state;
+    int score;
+    int depth;
+    long nodes;
+    bool hasMove;
+    Move best;
+    char bestSan[16];
+} AnalysisEntry;
+
+/**
+ * PgnGame struct: one game of the input file
+ * keys[i] is the position before ply i, keys[plies] the final position
+ */
+typedef struct PgnGame{
+    char* headers;
+    int headersLen;
+    char (*san)[16];
+    Move* moves;
+    uint64_t* keys;
+    int plies;
+    int capacity;
+    char result[8];
+    bool valid;
+} PgnGame;
+
+/**
+ * WorkDeque struct: one worker's task queue, tasks[top .. bottom)
+ */
+typedef struct WorkDeque{
+    pthread_mutex_t lock;
+    int* tasks;
+    int top;
+    int bottom;
+} WorkDeque;
+
+AnalysisEntry* analysisCache = NULL;
+int analysisCapacity = 0;
+int analysisCount = 0;
+
+WorkDeque* workDeques = NULL;
+int workerCount = 0;
+long annotateNodeLimit = ANNOTATE_DEFAULT_NODES;
+int annotateMoveTimeMs = 0;
+long* workerSteals = NULL;
+long* workerPositions = NULL;
+
+AnalysisEntry* CacheSlot(AnalysisEntry* table, int capacity, uint64_t key) {
+    int i = (int)(key & (uint64_t)(capacity - 1));
+    while (table[i].used && table[i].key != key) i = (i + 1) & (capacity - 1);
+    return &table[i];
+}
+
+/**
+ * @brief Adds the current position to the cache unless already there
+ * Single threaded, only called once a game has parsed completely
+ */
+void CacheInsertCurrent(uint64_t key) {
+    if ((analysisCount + 1) * 2 > analysisCapacity) {
+        int newCap = (analysisCapacity == 0) ? 1024 : analysisCapacity * 2;
+        AnalysisEntry* grown = calloc(newCap, sizeof(AnalysisEntry));
+        for (int i = 0; i < analysisCapacity; i++)
+            if (analysisCache[i].used) *CacheSlot(grown, newCap, analysisCache[i].key) = analysisCache[i];
+        free(analysisCache);
+        analysisCache = grown;
+        analysisCapacity = newCap;
     }
 
-    // ========================================================================
-    // EN PASSANT TARGET SETTING
-    // ========================================================================
-    if (p.type == PAWN && abs(dr - sr) == 2) {
-        enPassantTargetRow = (sr + dr) / 2;
-        enPassantTargetCol = sc;
-        enPassantPawnColor = p.color;
+    AnalysisEntry* e = CacheSlot(analysisCache, analysisCapacity, key);
+    if (e->used) return;
+
+    e->used = true;
+    e->key = key;
+    SaveGameState(&e->state);
+    analysisCount++;
+}
+
+AnalysisEntry* CacheLookup(uint64_t key) {
+    AnalysisEntry* e = CacheSlot(analysisCache, analysisCapacity, key);
+    return e->used ? e : NULL;
+}
+
+void AppendHeader(PgnGame* g, const char* text, int len) {
+    g->headers = realloc(g->headers, g->headersLen + len + 2);
+    memcpy(g->headers + g->headersLen, text, len);
+    g->headersLen += len;
+    g->headers[g->headersLen++] = '\n';
+    g->headers[g->headersLen] = '\0';
+}
+
+void ResetPgnBoard() {
+    InitBoard();
+    turn = WHITE_PIECE;
+    gameOver = false;
+    promotionActive = false;
+}
+
+void StartPgnGame(PgnGame* g) {
+    memset(g, 0, sizeof(*g));
+    g->valid = true;
+    strcpy(g->result, "*");
+    ResetPgnBoard();
+}
+
+/**
+ * @brief Plays one SAN move of the game being parsed, recording the position before it
+ */
+void AddPgnMove(PgnGame* g, const char* token) {
+    if (!g->valid) return;
+
+    Move m;
+    if (!ParseSan(token, &m)) {
+        TraceLog(LOG_WARNING, "ANNOTATE: illegal or ambiguous move '%s' at ply %d, game skipped", token, g->plies + 1);
+        g->valid = false;
+        return;
+    }
+
+    if (g->plies + 1 >= g->capacity) {
+        g->capacity = (g->capacity == 0) ? 128 : g->capacity * 2;
+        g->san = realloc(g->san, sizeof(*g->san) * g->capacity);
+        g->moves = realloc(g->moves, sizeof(Move) * g->capacity);
+        g->keys = realloc(g->keys, sizeof(uint64_t) * (g->capacity + 1));
+    }
+
+    g->keys[g->plies] = HashPosition();
+    g->moves[g->plies] = m;
+    MoveToSan(m, g->san[g->plies]);
+    g->plies++;
+
+    MakeMove(m);
+}
+
+/**
+ * @brief Adds the positions of a fully parsed game to the cache
+ * Deferred to here so games skipped half way never cost analysis time
+ */
+void FinishPgnGame(PgnGame* g) {
+    if (!g->valid) return;
+
+    if (g->capacity == 0) g->keys = malloc(sizeof(uint64_t));
+    g->keys[g->plies] = HashPosition();
+
+    ResetPgnBoard();
+    for (int i = 0; i < g->plies; i++) {
+        CacheInsertCurrent(g->keys[i]);
+        MakeMove(g->moves[i]);
+    }
+    CacheInsertCurrent(g->keys[g->plies]);
+}
+
+/**
+ * @brief Splits a PGN file into games and replays their moves
+ * Comments, variations and NAGs of the input are dropped
+ *
+ * @return number of games, the array is written to *gamesOut
+ */
+int ParsePgn(const char* text, PgnGame** gamesOut) {
+    PgnGame* games = NULL;
+    int count = 0, capacity = 0;
+    PgnGame* g = NULL;
+    bool inMoves = false;
+
+    for (const char* p = text; *p != '\0'; ) {
+        if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') { p++; continue; }
+
+        if (g == NULL || (*p == '[' && inMoves)) {
+            if (g != NULL) FinishPgnGame(g);
+            if (count == capacity) {
+                capacity = (capacity == 0) ? 16 : capacity * 2;
+                games = realloc(games, sizeof(PgnGame) * capacity);
+            }
+            g = &games[count++];
+            StartPgnGame(g);
+            inMoves = false;
+        }
+
+        if (*p == '[') {
+            const char* end = p;
+            bool quoted = false;
+            while (*end != '\0' && (*end != ']' || quoted)) {
+                if (*end == '"' && end[-1] != '\\') quoted = !quoted;
+                end++;
+            }
+            if (*end == ']') end++;
+            AppendHeader(g, p, (int)(end - p));
+            if (strncmp(p, "[FEN ", 5) == 0) {
+                TraceLog(LOG_WARNING, "ANNOTATE: games with a [FEN] start position are not supported, skipped");
+                g->valid = false;
+            }
+            p = end;
+            continue;
+        }
+
+        inMoves = true;
+
+        if (*p == '{') {
+            while (*p != '\0' && *p != '}') p++;
+            if (*p) p++;
+        } else if (*p == ';') {
+            while (*p != '\0' && *p != '\n') p++;
+        } else if (*p == '(') {
+            int depth = 0;
+            do {
+                if (*p == '(') depth++;
+                else if (*p == ')') depth--;
+                else if (*p == '{') while (p[1] != '\0' && *p != '}') p++;
+                p++;
+            } while (*p != '\0' && depth > 0);
+        } else {
+            char token[32];
+            int n = 0;
+            while (*p != '\0' && strchr(" \t\r\n{}();[", *p) == NULL) {
+                if (n < 31) token[n++] = *p;
+                p++;
+            }
+            token[n] = '\0';
+
+            if (strcmp(token, "1-0") == 0 || strcmp(token, "0-1") == 0 ||
+                strcmp(token, "1/2-1/2") == 0 || strcmp(token, "*") == 0) {
+                strcpy(g->result, token);
+                FinishPgnGame(g);
+                g = NULL;
+                continue;
+            }
+
+            // strip move numbers like "12." or "12..."
+            int skip = 0;
+            while (token[skip] >= '0' && token[skip] <= '9') skip++;
+            if (token[skip] == '.') {
+                while (token[skip] == '.') skip++;
+            } else {
+                skip = 0;
+            }
+
+            if (token[skip] != '\0' && token[skip] != '$') AddPgnMove(g, token + skip);
+        }
+    }
+    if (g != NULL) {
+        // a trailing game with no headers and no moves is whitespace after the last result
+        if (g->plies == 0 && g->headersLen == 0) count--;
+        else FinishPgnGame(g);
+    }
+
+    *gamesOut = games;
+    return count;
+}
+
+/**
+ * @brief Analyses one cached position with the configured budget
+ */
+void AnalyzeEntry(AnalysisEntry* e) {
+    LoadGameState(&e->state);
+
+    SearchContext ctx = {0};
+    ctx.nodeLimit = annotateNodeLimit;
+    if (annotateMoveTimeMs > 0) ctx.deadline = NowMicros() + (uint64_t)annotateMoveTimeMs * 1000u;
+
+    Move best;
+    e->score = SearchPosition(&ctx, &best, &e->depth);
+    e->nodes = ctx.nodes;
+    e->hasMove = e->depth > 0;
+    if (e->hasMove) {
+        e->best = best;
+        MoveToSan(best, e->bestSan);
+    }
+}
+
+int PopOwnTask(int worker) {
+    WorkDeque* d = &workDeques[worker];
+    int task = -1;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) task = d->tasks[--d->bottom];
+    pthread_mutex_unlock(&d->lock);
+    return task;
+}
+
+int StealTask(int worker) {
+    for (int k = 1; k < workerCount; k++) {
+        WorkDeque* d = &workDeques[(worker + k) % workerCount];
+        int task = -1;
+
+        pthread_mutex_lock(&d->lock);
+        if (d->bottom > d->top) task = d->tasks[d->top++];
+        pthread_mutex_unlock(&d->lock);
+
+        if (task != -1) {
+            workerSteals[worker]++;
+            return task;
+        }
+    }
+    return -1;
+}
+
+void* AnnotateWorker(void* arg) {
+    int worker = (int)(intptr_t)arg;
+
+    for (;;) {
+        int task = PopOwnTask(worker);
+        if (task == -1) task = StealTask(worker);
+        if (task == -1) break;     // no task is ever added once the pool runs
+
+        AnalyzeEntry(&analysisCache[task]);
+        workerPositions[worker]++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Clamped score so mate scores compare sensibly with centipawns
+ */
+int ClampScore(int score) {
+    if (score > 2000) return 2000;
+    if (score < -2000) return -2000;
+    return score;
+}
+
+void FormatEval(const AnalysisEntry* e, char* out) {
+    int white = (e->state.turn == WHITE_PIECE) ? e->score : -e->score;
+
+    if (abs(white) > MATE_BOUND) {
+        int plies = MATE_SCORE - abs(white);
+        sprintf(out, "#%s%d", (white < 0) ? "-" : "", (plies + 1) / 2);
     } else {
-        ResetEnPassant();
+        sprintf(out, "%.2f", white / 100.0);
     }
+}
 
-// ======================== 
-// PAWN PROMOTION TRIGGER 
-// ========================
-if (p.type == PAWN &&
-   ((p.color == WHITE_PIECE && dr == 0) ||
-    (p.color == BLACK_PIECE && dr == 7))) {
+/**
+ * @brief Buffered writer that wraps movetext at PGN_LINE_WIDTH
+ */
+typedef struct PgnWriter{
+    FILE* f;
+    int column;
+} PgnWriter;
+
+void WriteToken(PgnWriter* w, const char* token, int len) {
+    if (w->column > 0 && w->column + 1 + len > PGN_LINE_WIDTH) {
+        fputc('\n', w->f);
+        w->column = 0;
+    } else if (w->column > 0) {
+        fputc(' ', w->f);
+        w->column++;
+    }
+    fwrite(token, 1, len, w->f);
+    w->column += len;
+}
 
-    promotionActive = true;
-    promotionRow = dr;
-    promotionCol = dc;
-    promotionColor = p.color;
+/**
+ * @brief Writes space separated words, each may start a new line
+ */
+void WriteWords(PgnWriter* w, const char* text) {
+    while (*text != '\0') {
+        while (*text == ' ') text++;
+        int len = (int)strcspn(text, " ");
+        if (len > 0) WriteToken(w, text, len);
+        text += len;
+    }
+}
+
+/**
+ * @brief Writes one game with [%eval] comments and mistake/blunder tags
+ *
+ * @param counts receives inaccuracies, mistakes and blunders
+ */
+void WriteAnnotatedGame(FILE* f, const PgnGame* g, int counts[3]) {
+    fputs(g->headers != NULL ? g->headers : "", f);
+    fputs("[Annotator \"chess-gui\"]\n\n", f);
+
+    PgnWriter w = { f, 0 };
+
+    for (int i = 0; i < g->plies; i++) {
+        const AnalysisEntry* before = CacheLookup(g->keys[i]);
+        const AnalysisEntry* after = CacheLookup(g->keys[i + 1]);
+        bool white = before->state.turn == WHITE_PIECE;
+        char token[192];
+
+        // every move carries a comment, so black's moves get their own number too
+        sprintf(token, white ? "%d." : "%d...", i / 2 + 1);
+        WriteWords(&w, token);
+
+        // loss for the mover: best available minus what the played move kept
+        int loss = ClampScore(before->score) - (-ClampScore(after->score));
+        bool best = before->hasMove && SameMove(before->best, g->moves[i]);
+        const char* label = NULL;
+        const char* nag = NULL;
+        int kind = -1;
+
+        if (!best && loss >= BLUNDER_LOSS)          { label = "Blunder"; nag = "??"; kind = 2; }
+        else if (!best && loss >= MISTAKE_LOSS)     { label = "Mistake"; nag = "?"; kind = 1; }
+        else if (!best && loss >= INACCURACY_LOSS)  { label = "Inaccuracy"; nag = "?!"; kind = 0; }
+        if (kind != -1) counts[kind]++;
+
+        sprintf(token, "%s%s", g->san[i], nag != NULL ? nag : "");
+        WriteWords(&w, token);
+
+        char eval[16];
+        FormatEval(after, eval);
+        if (after->depth == 0) {
+            sprintf(token, "{ %s }", (after->score == 0) ? "Stalemate." : "Checkmate.");
+        } else if (label != NULL) {
+            sprintf(token, "{ [%%eval %s] %s. Best was %s. }", eval, label, before->bestSan);
+        } else {
+            sprintf(token, "{ [%%eval %s] }", eval);
+        }
+
+        // a comment is never split, PGN readers expect [%eval x] on one line
+        WriteToken(&w, token, (int)strlen(token));
+    }
+
+    WriteWords(&w, g->result);
+    fputs("\n\n", f);
+}
+
+/**
+ * @brief Entry point of the headless annotator
+ *
+ * @return process exit code
+ */
+int RunAnnotator(const char* inPath, const char* outPath, long nodes, int moveTimeMs, int threads) {
+    char* text = LoadFileText(inPath);
+    if (text == NULL) {
+        TraceLog(LOG_ERROR, "ANNOTATE: could not read %s", inPath);
+        return 1;
+    }
+
+    InitZobrist();
+    annotateNodeLimit = (moveTimeMs > 0 && nodes == 0) ? 0 : (nodes > 0 ? nodes : ANNOTATE_DEFAULT_NODES);
+    annotateMoveTimeMs = moveTimeMs;
+
+    PgnGame* games = NULL;
+    int gameCount = ParsePgn(text, &games);
+    UnloadFileText(text);
+
+    long plies = 0;
+    for (int i = 0; i < gameCount; i++) if (games[i].valid) plies += games[i].plies + 1;
+
+    // deal the distinct positions round-robin onto the workers
+#ifdef __linux__
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    workerCount = (threads > 0) ? threads : 4;
+    workDeques = calloc(workerCount, sizeof(WorkDeque));
+    workerSteals = calloc(workerCount, sizeof(long));
+    workerPositions = calloc(workerCount, sizeof(long));
+    for (int w = 0; w < workerCount; w++) {
+        pthread_mutex_init(&workDeques[w].lock, NULL);
+        workDeques[w].tasks = malloc(sizeof(int) * (analysisCount / workerCount + 1));
+    }
+    for (int i = 0, n = 0; i < analysisCapacity; i++) {
+        if (!analysisCache[i].used) continue;
+        WorkDeque* d = &workDeques[n++ % workerCount];
+        d->tasks[d->bottom++] = i;
+    }
+
+    uint64_t start = NowMicros();
+    pthread_t* pool = malloc(sizeof(pthread_t) * workerCount);
+    for (int w = 0; w < workerCount; w++)
+        pthread_create(&pool[w], NULL, AnnotateWorker, (void*)(intptr_t)w);
+    for (int w = 0; w < workerCount; w++)
+        pthread_join(pool[w], NULL);
+    double elapsed = (NowMicros() - start) / 1e6;
+
+    int status = 0;
+    FILE* out = fopen(outPath, "w");
+    if (out == NULL) {
+        TraceLog(LOG_ERROR, "ANNOTATE: could not write %s", outPath);
+        status = 1;
+    } else {
+        int counts[3] = {0};
+        int written = 0;
+        for (int i = 0; i < gameCount; i++) {
+            if (!games[i].valid) continue;
+            WriteAnnotatedGame(out, &games[i], counts);
+            written++;
+        }
+        fclose(out);
+
+        long totalNodes = 0, steals = 0;
+        for (int i = 0; i < analysisCapacity; i++) if (analysisCache[i].used) totalNodes += analysisCache[i].nodes;
+        for (int w = 0; w < workerCount; w++) steals += workerSteals[w];
+
+        printf("annotate: %d of %d games, %ld positions, %d distinct (%ld served from cache)\n",
+               written, gameCount, plies, analysisCount, plies - analysisCount);
+        printf("analysis: %.2f s on %d threads, %ld nodes (%.0f nodes/s), %ld steals\n",
+               elapsed, workerCount, totalNodes, totalNodes / (elapsed > 0 ? elapsed : 1), steals);
+        printf("found: %d inaccuracies, %d mistakes, %d blunders -> %s\n", counts[0], counts[1], counts[2], outPath);
+    }
+
+    for (int i = 0; i < gameCount; i++) {
+        free(games[i].headers);
+        free(games[i].san);
+        free(games[i].moves);
+        free(games[i].keys);
+    }
+    for (int w = 0; w < workerCount; w++) {
+        pthread_mutex_destroy(&workDeques[w].lock);
+        free(workDeques[w].tasks);
+    }
+    free(games);
+    free(pool);
+    free(workDeques);
+    free(workerSteals);
+    free(workerPositions);
+    free(analysisCache);
+    return status;
 }
 
-    // ========================================================================
-    // CASTLING HANDLING
-    // ========================================================================
-    if (p.type == KING && abs(dc - sc) == 2) {
-        // Determine rook positions
-        int rookCol = (dc > sc) ? 7 : 0;
-        int newRookCol = (dc > sc) ? dc - 1 : dc + 1;
+//===========================================================================
+// MATE SOLVER
+//===========================================================================
+
+/*
+ * Depth-bounded df-pn (depth-first proof-number search) for forced mates.
+ * The side to move is the attacker. OR nodes are attacker moves, AND nodes
+ * defender replies, and "remaining" counts attacker moves still allowed.
+ * An AND node is proven when the defender is checkmated and disproven on
+ * stalemate or once remaining hits 0. Proof and disproof numbers live in a
+ * fixed-size bucketed table whose key includes remaining, so memory stays
+ * bounded; when it fills, the entry with the least work is replaced.
+ *
+ * Mate in 1, 2, ... maxMoves is tried in turn, so the reported mate is the
+ * shortest one.
+ */
+
+#define DFPN_INF 100000000u
+#define DFPN_BUCKET 4
+#define DFPN_DEFAULT_HASH_MB 64
+#define MATE_DEFAULT_MOVES 3
+#define MATE_BATCH_MOVES 5
+#define MATE_GUI_NODES 2000000
+
+/**
+ * DfpnEntry struct: proof and disproof number of one (position, remaining) pair
+ * work: nodes spent below this entry, the replacement priority
+ */
+typedef struct DfpnEntry{
+    uint64_t key;
+    uint32_t pn;
+    uint32_t dn;
+    uint32_t work;
+} DfpnEntry;
+
+/**
+ * DfpnSolver struct: table and budget of one solver (one per thread)
+ * A zero nodeLimit means no limit, cancel may be NULL
+ */
+typedef struct DfpnSolver{
+    DfpnEntry* table;
+    size_t bucketMask;
+    long nodes;
+    long nodeLimit;
+    volatile bool* cancel;
+    bool aborted;
+} DfpnSolver;
 
-        board[dr][newRookCol] = board[sr][rookCol];
-        board[dr][newRookCol].moved = true;
+/**
+ * MateResult struct: outcome of SolveMate
+ * mateIn: moves to mate for the side to move, 0 if none was proven
+ * aborted: budget ran out before the answer for every depth was known
+ */
+typedef struct MateResult{
+    int mateIn;
+    bool hasMove;
+    Move key;
+    char keySan[16];
+    long nodes;
+    double seconds;
+    bool aborted;
+} MateResult;
 
+/**
+ * @brief Allocates the table, rounded down to a power of two buckets
+ */
+bool DfpnInit(DfpnSolver* s, int hashMb) {
+    size_t buckets = 1;
+    while (buckets * 2 * DFPN_BUCKET * sizeof(DfpnEntry) <= (size_t)hashMb * 1024 * 1024) buckets *= 2;
+
+    memset(s, 0, sizeof(*s));
+    s->table = calloc(buckets * DFPN_BUCKET, sizeof(DfpnEntry));
+    s->bucketMask = buckets - 1;
+    return s->table != NULL;
+}
 
-        board[sr][rookCol] = (Piece){EMPTY, NONE_PIECE, false, false};
-    }
+void DfpnClear(DfpnSolver* s) {
+    memset(s->table, 0, (s->bucketMask + 1) * DFPN_BUCKET * sizeof(DfpnEntry));
+}
 
-    // ========================================================================
-    // FINAL BOARD UPDATE
-    // ========================================================================
-    p.moved = true;
-    board[dr][dc] = p;
-    board[sr][sc] = (Piece){EMPTY, NONE_PIECE, false, false};
+void DfpnFree(DfpnSolver* s) {
+    free(s->table);
+    s->table = NULL;
+}
 
-    return true;
+uint64_t DfpnKey(int remaining) {
+    return HashPosition() ^ (0x9E3779B97F4A7C15ull * (uint64_t)(remaining + 1));
 }
+
 /**
- * @brief Determine if specified king is in check
- *
- * @param color color of king to check
- *
- * @return true if king is under attack
+ * @brief Reads pn/dn of a node, unknown nodes count as (1, 1)
  */
-bool IsInCheck(PieceColor color) {
-    int kr = -1, kc = -1;
+void DfpnLookup(DfpnSolver* s, uint64_t key, uint32_t* pn, uint32_t* dn) {
+    DfpnEntry* bucket = &s->table[(key & s->bucketMask) * DFPN_BUCKET];
 
-    // ========================================================================
-    // FIND THE KING
-    // ========================================================================
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            if (board[r][c].type == KING && board[r][c].color == color) {
-                kr = r;
-                kc = c;
-                break;
-            }
+    for (int i = 0; i < DFPN_BUCKET; i++) {
+        if (bucket[i].key == key && bucket[i].work != 0) {
+            *pn = bucket[i].pn;
+            *dn = bucket[i].dn;
+            return;
         }
-        if (kr != -1) break;
     }
+    *pn = 1;
+    *dn = 1;
+}
 
-    if (kr == -1) return false;
+uint32_t DfpnAdd(uint32_t a, uint32_t b) {
+    return (a >= DFPN_INF - b) ? DFPN_INF : a + b;
+}
 
-    // ========================================================================
-    // CHECK FOR ATTACKING PIECES
-    // ========================================================================
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            Piece p = board[r][c];
+void DfpnStore(DfpnSolver* s, uint64_t key, uint32_t pn, uint32_t dn, uint32_t work) {
+    DfpnEntry* bucket = &s->table[(key & s->bucketMask) * DFPN_BUCKET];
+    DfpnEntry* victim = &bucket[0];
 
-            if (p.type == EMPTY || p.color == color) continue;
+    for (int i = 0; i < DFPN_BUCKET; i++) {
+        if (bucket[i].key == key || bucket[i].work == 0) {
+            victim = &bucket[i];
+            break;
+        }
+        if (bucket[i].work < victim->work) victim = &bucket[i];
+    }
 
-            // ================================================================
-            // SPECIAL CASE: PAWN ATTACKS
-            // ================================================================
-            if (p.type == PAWN) {
-                int dir = (p.color == WHITE_PIECE) ? -1 : 1;
-                if (r + dir == kr && abs(c - kc) == 1)
-                    return true;
-            }
-            // ================================================================
-            // OTHER PIECES: USE VALID MOVE CHECK
-            // ================================================================
-            else if (IsValidMove(r, c, kr, kc)) {
-                return true;
+    // work accumulates over revisits so that expensive subtrees stay cached
+    uint32_t previous = (victim->key == key) ? victim->work : 0;
+    victim->key = key;
+    victim->pn = pn;
+    victim->dn = dn;
+    victim->work = DfpnAdd(previous, (work > 0) ? work : 1);
+}
+
+/**
+ * @brief Multiple iterative deepening step of df-pn on the current position
+ * Written in phi/delta form: phi is pn at OR nodes and dn at AND nodes.
+ * Expands below this node until phi >= thPhi or delta >= thDelta.
+ * Child numbers are kept on the stack while the node is expanded, so losing
+ * them from a small table costs time but never progress.
+ */
+void DfpnMid(DfpnSolver* s, uint64_t key, int remaining, bool orNode, uint32_t thPhi, uint32_t thDelta,
+             uint32_t* pnOut, uint32_t* dnOut) {
+    DfpnLookup(s, key, pnOut, dnOut);
+    s->nodes++;
+    if ((s->nodeLimit > 0 && s->nodes >= s->nodeLimit) || (s->cancel != NULL && *s->cancel)) s->aborted = true;
+    if (s->aborted) return;
+
+    long startNodes = s->nodes;
+    Move moves[MAX_MOVES];
+    int count = GenerateLegalMoves(moves);
+
+    if (count == 0 || (!orNode && remaining == 0)) {
+        bool mated = !orNode && count == 0 && IsInCheck(turn);
+        *pnOut = mated ? 0 : DFPN_INF;
+        *dnOut = mated ? DFPN_INF : 0;
+        DfpnStore(s, key, *pnOut, *dnOut, 1);
+        return;
+    }
+
+    int childRemaining = orNode ? remaining - 1 : remaining;
+    uint64_t childKeys[MAX_MOVES];
+    uint32_t childPn[MAX_MOVES], childDn[MAX_MOVES];
+    for (int i = 0; i < count; i++) {
+        GameState saved;
+        SaveGameState(&saved);
+        MakeMove(moves[i]);
+        childKeys[i] = DfpnKey(childRemaining);
+        LoadGameState(&saved);
+        DfpnLookup(s, childKeys[i], &childPn[i], &childDn[i]);
+    }
+
+    uint32_t phi = 0, delta = 0;
+    for (;;) {
+        // phi(n) = min delta(child), delta(n) = sum phi(child)
+        int best = -1;
+        uint32_t bestDelta = DFPN_INF, secondDelta = DFPN_INF, bestPhi = 0;
+        phi = DFPN_INF;
+        delta = 0;
+
+        for (int i = 0; i < count; i++) {
+            uint32_t cPhi = orNode ? childDn[i] : childPn[i];
+            uint32_t cDelta = orNode ? childPn[i] : childDn[i];
+
+            delta = DfpnAdd(delta, cPhi);
+            if (cDelta < bestDelta) {
+                secondDelta = bestDelta;
+                bestDelta = cDelta;
+                bestPhi = cPhi;
+                best = i;
+            } else if (cDelta < secondDelta) {
+                secondDelta = cDelta;
             }
         }
+        phi = bestDelta;
+
+        if (phi >= thPhi || delta >= thDelta || s->aborted) break;
+
+        uint32_t childThPhi = (thDelta >= DFPN_INF) ? DFPN_INF : thDelta - delta + bestPhi;
+        uint32_t childThDelta = (thPhi < secondDelta + 1) ? thPhi : DfpnAdd(secondDelta, 1);
+
+        GameState saved;
+        SaveGameState(&saved);
+        MakeMove(moves[best]);
+        DfpnMid(s, childKeys[best], childRemaining, !orNode, childThPhi, childThDelta, &childPn[best], &childDn[best]);
+        LoadGameState(&saved);
     }
 
-    return false;
+    *pnOut = orNode ? phi : delta;
+    *dnOut = orNode ? delta : phi;
+    DfpnStore(s, key, *pnOut, *dnOut, (uint32_t)(s->nodes - startNodes + 1));
 }
 
 /**
- * @brief Check if player has any legal moves
- *
- * @param color Player color to check
- *
- * @return true if at least one legal move exists
+ * @brief Finds the shortest forced mate of at most maxMoves for the side to move
+ * Uses the rules globals of the calling thread, the position is left unchanged
  */
-bool HasAnyValidMove(PieceColor color) {
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            if (board[r][c].color == color) {
-                for(int dr = 0; dr < 8; dr++){
-                    for(int dc = 0; dc < 8; dc++){
-                        if (IsValidMove(r, c, dr, dc) && !TestMoveForCheck(color, r, c, dr, dc)) {
-                            return true;
-                        }
-                    }
+MateResult SolveMate(DfpnSolver* s, int maxMoves) {
+    MateResult result = {0};
+    uint64_t start = NowMicros();
+    s->nodes = 0;
+    s->aborted = false;
+
+    for (int n = 1; n <= maxMoves && !s->aborted; n++) {
+        uint32_t pn, dn;
+        DfpnMid(s, DfpnKey(n), n, true, DFPN_INF, DFPN_INF, &pn, &dn);
+        if (s->aborted) break;
+        if (pn != 0) continue;
+
+        result.mateIn = n;
+
+        // the key move is a child that is proven; re-prove it if it was evicted
+        Move moves[MAX_MOVES];
+        int count = GenerateLegalMoves(moves);
+        for (int pass = 0; pass < 2 && !result.hasMove; pass++) {
+            for (int i = 0; i < count && !result.hasMove; i++) {
+                GameState saved;
+                SaveGameState(&saved);
+                MakeMove(moves[i]);
+                uint64_t childKey = DfpnKey(n - 1);
+                if (pass == 0) DfpnLookup(s, childKey, &pn, &dn);
+                else DfpnMid(s, childKey, n - 1, false, DFPN_INF, DFPN_INF, &pn, &dn);
+                LoadGameState(&saved);
+
+                if (pn == 0) {
+                    result.hasMove = true;
+                    result.key = moves[i];
+                    MoveToSan(moves[i], result.keySan);
                 }
             }
         }
+        break;
     }
-    return false;
+
+    result.nodes = s->nodes;
+    result.aborted = s->aborted;
+    result.seconds = (NowMicros() - start) / 1e6;
+    return result;
 }
 
 /**
- * IsCheckmate(): Determine if player is in checkmate
- * Checkmate = King is in check AND has no legal moves
+ * @brief Sets up the rules globals from a FEN or the first four EPD fields
+ * Castling rights become the moved flags of kings and rooks, pawns off
+ * their start rank count as moved.
  *
- * @param color Player color to check
- * @return true if player is checkmated
+ * @return pointer just past the fourth field, NULL if malformed
  */
-bool IsCheckmate(PieceColor color){
-    return IsInCheck(color) && !HasAnyValidMove(color);
+const char* ParseFen(const char* fen) {
+    memset(board, 0, sizeof(board));
+    for (int r = 0; r < 8; r++)
+        for (int c = 0; c < 8; c++)
+            board[r][c] = (Piece){EMPTY, NONE_PIECE, false, false};
+
+    const char* p = fen;
+    while (*p == ' ') p++;
+
+    int r = 0, c = 0;
+    for (; *p != '\0' && *p != ' '; p++) {
+        if (*p == '/') { r++; c = 0; continue; }
+        if (*p >= '1' && *p <= '8') { c += *p - '0'; continue; }
+
+        PieceColor color = (*p >= 'a') ? BLACK_PIECE : WHITE_PIECE;
+        char upper = (*p >= 'a') ? *p - 32 : *p;
+        PieceType type = EMPTY;
+        for (int t = PAWN; t <= KING; t++) if (upper == pieceLetter[t]) type = t;
+        if (type == EMPTY || r > 7 || c > 7) return NULL;
+
+        bool moved = true;
+        if (type == PAWN) moved = (color == WHITE_PIECE) ? r != 6 : r != 1;
+        board[r][c++] = (Piece){type, color, moved, false};
+    }
+    if (r != 7) return NULL;
+
+    while (*p == ' ') p++;
+    if (*p != 'w' && *p != 'b') return NULL;
+    turn = (*p == 'w') ? WHITE_PIECE : BLACK_PIECE;
+    p++;
+
+    while (*p == ' ') p++;
+    for (; *p != '\0' && *p != ' '; p++) {
+        int row = (*p == 'K' || *p == 'Q') ? 7 : 0;
+        int rookCol = (*p == 'K' || *p == 'k') ? 7 : 0;
+        if (strchr("KQkq", *p) == NULL) continue;
+
+        if (board[row][4].type == KING) board[row][4].moved = false;
+        if (board[row][rookCol].type == ROOK) board[row][rookCol].moved = false;
+    }
+
+    ResetEnPassant();
+    while (*p == ' ') p++;
+    if (*p >= 'a' && *p <= 'h' && (p[1] == '3' || p[1] == '6')) {
+        enPassantTargetCol = *p - 'a';
+        enPassantTargetRow = 7 - (p[1] - '1');
+        enPassantPawnColor = (turn == WHITE_PIECE) ? BLACK_PIECE : WHITE_PIECE;
+        p += 2;
+    } else if (*p == '-') {
+        p++;
+    }
+
+    gameOver = false;
+    promotionActive = false;
+    return p;
 }
 
 /**
- * @brief Determine if player is in check
- *
- * @param color Player color to check
- *
- * @return true if player is checkmated
+ * @brief Strips check and annotation marks so SAN strings compare equal
  */
-bool IsCheckMate(PieceColor color){
-    return IsInCheck(color) && !HasAnyValidMove(color);
+void NormalizeSan(const char* in, char* out, int size) {
+    int n = 0;
+    for (; *in != '\0' && *in != ' ' && *in != ';' && n < size - 1; in++)
+        if (strchr("+#!?", *in) == NULL) out[n++] = *in;
+    out[n] = '\0';
 }
 
 /**
- * @brief  Check if path between two squares is unobstructed
- *
- * @param sr Source row
- * @param sc Source column
- * @param dr Destination row
- * @param dc Destination column
+ * @brief Reads the next "opcode operand;" operation of an EPD record
+ * Quotes around an operand are dropped and a ';' inside them does not end
+ * the operation.
  *
- * @return true if all intermediate squares are empty
+ * @return pointer past the operation, NULL when none is left
  */
-bool IsPathClear(int sr, int sc, int dr, int dc) {
-    int rs = (dr > sr) ? 1 : (dr < sr) ? -1 : 0;
-    int cs = (dc > sc) ? 1 : (dc < sc) ? -1 : 0;
-
-    for (int r = sr + rs, c = sc + cs; r != dr || c != dc; r += rs, c += cs) {
-        if (board[r][c].type != EMPTY)
-            return false;
+const char* NextEpdOp(const char* p, char* opcode, int opcodeSize, char* operand, int operandSize) {
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == '\0' || *p == '\n' || *p == '\r') return NULL;
+
+    int n = 0;
+    for (; *p != '\0' && strchr(" \t\r\n;", *p) == NULL; p++)
+        if (n < opcodeSize - 1) opcode[n++] = *p;
+    opcode[n] = '\0';
+
+    while (*p == ' ' || *p == '\t') p++;
+    bool quoted = false;
+    n = 0;
+    for (; *p != '\0' && *p != '\n' && *p != '\r' && (quoted || *p != ';'); p++) {
+        if (*p == '"') { quoted = !quoted; continue; }
+        if (n < operandSize - 1) operand[n++] = *p;
     }
+    while (n > 0 && operand[n - 1] == ' ') n--;
+    operand[n] = '\0';
 
-    return true;
+    if (*p == ';') p++;
+    return p;
 }
 
 /**
- * @brief Simulate move to check if it leaves king in check
- * Uses temporary board modification to test move consequences
- *
- * @param color Color of moving Player
- * @param sr Source Row
- * @param sc Source Column
- * @param dr Destination Row
- * @param dc Destination Column
+ * @brief Headless batch solver over an EPD file
+ * Uses the "dm" (mate in N) opcode as the depth when present, else maxMoves;
+ * "bm" is checked against the key move found. Zero arguments pick defaults.
  *
- * @return true if move would leave king in check
+ * @return process exit code: 0 when every puzzle was solved as expected
  */
-bool TestMoveForCheck(PieceColor color, int sr, int sc, int dr, int dc) {
-
-    Piece src = board[sr][sc];
-    Piece dst = board[dr][dc];
-    Piece capturedPawn = {EMPTY, NONE_PIECE, false, false};
-    int capturedRow = -1, capturedCol = -1;
+int RunMateBatch(const char* path, int maxMoves, long nodeLimit, int hashMb) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        TraceLog(LOG_ERROR, "SOLVE: could not open %s", path);
+        return 1;
+    }
 
-    // ========================================================================
-    // EN PASSANT CAPTURE SIMULATION
-    // ========================================================================
-    bool isEP = (src.type == PAWN && dr == enPassantTargetRow && dc == enPassantTargetCol && src.color != enPassantPawnColor);
+    if (maxMoves <= 0) maxMoves = MATE_BATCH_MOVES;
+    if (hashMb <= 0) hashMb = DFPN_DEFAULT_HASH_MB;
 
-    if (isEP) {
-        capturedRow = (src.color == WHITE_PIECE) ? dr + 1 : dr - 1;
-        capturedCol = dc;
-        capturedPawn = board[capturedRow][capturedCol];
-        board[capturedRow][capturedCol] = (Piece){EMPTY, NONE_PIECE, false, false};
+    InitZobrist();
+    DfpnSolver solver;
+    if (!DfpnInit(&solver, hashMb)) {
+        fclose(f);
+        return 1;
     }
+    solver.nodeLimit = nodeLimit;
 
-    // ========================================================================
-    // TEMPORARY MOVE EXECUTION
-    // ========================================================================
-    board[dr][dc] = src;
-    board[sr][sc] = (Piece){EMPTY, NONE_PIECE, false, false};
-
-    // ========================================================================
-    // CHECK DETECTION
-    // ========================================================================
-    bool inCheck = IsInCheck(color);
+    char line[512];
+    int total = 0, solved = 0, lineNo = 0;
+    double totalSeconds = 0, worst = 0;
+    long totalNodes = 0;
 
-    // ========================================================================
-    // BOARD RESTORATION
-    // ========================================================================
-    board[sr][sc] = src;
-    board[dr][dc] = dst;
+    printf("%-24s %-6s %-9s %-9s %-8s %10s %10s\n", "id", "mate", "key", "expected", "status", "ms", "nodes");
 
-    if (isEP) {
-        board[capturedRow][capturedCol] = capturedPawn;
-    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineNo++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
 
-    return inCheck;
-}
+        const char* ops = ParseFen(line);
+        if (ops == NULL) {
+            TraceLog(LOG_WARNING, "SOLVE: %s:%d: malformed position", path, lineNo);
+            continue;
+        }
 
-/**
- * @brief Clear en Passant tracking variables
- * Called after each move (except when a pawn moves two squares)
- */
-void ResetEnPassant() {
-    enPassantTargetRow = -1;
-    enPassantTargetCol = -1;
-    enPassantPawnColor = NONE_PIECE;
-}
+        char id[64] = "";
+        char expectedKey[64] = "-";
+        int expectedMate = 0;
+        bool hasBm = false;
+        char opcode[16], operand[64];
+        for (const char* op = ops; (op = NextEpdOp(op, opcode, sizeof(opcode), operand, sizeof(operand))) != NULL; ) {
+            if (strcmp(opcode, "id") == 0) {
+                strcpy(id, operand);
+            } else if (strcmp(opcode, "dm") == 0) {
+                expectedMate = atoi(operand);
+            } else if (strcmp(opcode, "bm") == 0) {
+                strcpy(expectedKey, operand);
+                hasBm = true;
+            }
+        }
+        if (id[0] == '\0') sprintf(id, "line %d", lineNo);
+
+        DfpnClear(&solver);
+        MateResult res = SolveMate(&solver, expectedMate > 0 ? expectedMate : maxMoves);
+
+        // bm may list several moves, any of them counts
+        bool keyOk = !hasBm;
+        char found[16], want[16];
+        NormalizeSan(res.keySan, found, sizeof(found));
+        for (const char* m = expectedKey; *m != '\0' && !keyOk; ) {
+            while (*m == ' ') m++;
+            NormalizeSan(m, want, sizeof(want));
+            keyOk = want[0] != '\0' && strcmp(found, want) == 0;
+            m += strcspn(m, " ");
+        }
+        bool ok = res.mateIn > 0 && (expectedMate == 0 || res.mateIn == expectedMate) && keyOk;
 
-/**
- * @brief Draws the Promotion Menu for Piece Selection 
- */
-void DrawPromotionMenu(){
+        char mate[16];
+        if (res.mateIn > 0) sprintf(mate, "#%d", res.mateIn);
+        else strcpy(mate, res.aborted ? "?" : "none");
 
-    if (!promotionActive) return;
+        printf("%-24.24s %-6s %-9s %-9.9s %-8s %10.1f %10ld\n", id, mate, res.hasMove ? res.keySan : "-",
+               expectedKey, ok ? "ok" : (res.aborted ? "budget" : "FAIL"), res.seconds * 1000.0, res.nodes);
 
-    DrawRectangle(0, 0,
-        GetScreenWidth(),
-        GetScreenHeight(),
-        Fade(BLACK, 0.6f));
+        total++;
+        if (ok) solved++;
+        totalSeconds += res.seconds;
+        totalNodes += res.nodes;
+        if (res.seconds > worst) worst = res.seconds;
+    }
+    fclose(f);
+    DfpnFree(&solver);
 
-    Rectangle box = {
-        BOARD_SIZE*TILE_SIZE/2 - 160,
-        BOARD_SIZE*TILE_SIZE/2 - 60,
-        320,
-        120
-    };
+    printf("solved %d/%d in %.1f ms (avg %.1f ms, worst %.1f ms), %ld nodes, %.0f nodes/s\n",
+           solved, total, totalSeconds * 1000.0, total ? totalSeconds * 1000.0 / total : 0, worst * 1000.0,
+           totalNodes, totalNodes / (totalSeconds > 0 ? totalSeconds : 1));
+    return solved == total ? 0 : 1;
+}
 
-    DrawRectangleRounded(box, 0.2f, 10, GetColor(0x202020FF));
-    DrawText("Choose Promotion", box.x + 50, box.y + 10, 20, RAYWHITE);
+//===========================================================================
+// MATE SOLVER GUI
+//===========================================================================
 
-    PieceType options[4] = {QUEEN, ROOK, BISHOP, KNIGHT};
+// Background solve for the GUI, started with M. The result is shown only
+// while the board still matches the position it was solved for.
+pthread_t solveThread;
+pthread_mutex_t solveMutex = PTHREAD_MUTEX_INITIALIZER;
+JobState solveState = JOB_IDLE;
+GameState solveJobState;
+MateResult solveResult;
+uint64_t solveKey = 0;
+bool solveHasResult = false;
+volatile bool solveCancel = false;
+
+void* SolveWorker(void* arg) {
+    (void)arg;
+    LoadGameState(&solveJobState);
+
+    DfpnSolver solver;
+    MateResult res = {0};
+    if (DfpnInit(&solver, DFPN_DEFAULT_HASH_MB)) {
+        solver.nodeLimit = MATE_GUI_NODES;
+        solver.cancel = &solveCancel;
+        res = SolveMate(&solver, MATE_DEFAULT_MOVES);
+        DfpnFree(&solver);
+    }
 
-    for (int i = 0; i < 4; i++) {
+    pthread_mutex_lock(&solveMutex);
+    solveResult = res;
+    solveState = JOB_READY;
+    pthread_mutex_unlock(&solveMutex);
+    return NULL;
+}
 
-        Rectangle slot = {
-            box.x + 20 + i*70,
-            box.y + 50,
-            60,
-            60
-        };
+/**
+ * @brief Starts solving the current position for the side to move
+ * Ignored while a solve is already running
+ */
+void RequestMateSolve() {
+    if (solveState != JOB_IDLE || promotionActive || gameOver) return;
+
+    InitZobrist();
+    SaveGameState(&solveJobState);
+    solveKey = HashPosition();
+    solveHasResult = false;
+    solveCancel = false;
+
+    solveState = JOB_BUSY;
+    if (pthread_create(&solveThread, NULL, SolveWorker, NULL) != 0) {
+        solveState = JOB_IDLE;
+        return;
+    }
 
-        DrawRectangleRounded(slot, 0.2f, 10, DARKGRAY);
+    // record/replay: finish on the requesting frame so every replay does the same work per frame
+    if (replayActive || recordFile != NULL) {
+        pthread_join(solveThread, NULL);
+        solveHasResult = true;
+        solveState = JOB_IDLE;
+    }
+}
 
-        int colorIdx = (promotionColor == WHITE_PIECE) ? 0 : 1;
-        Texture2D tex = pieceTextures[colorIdx][options[i]];
+/**
+ * @brief Called once per frame: picks up a finished solve
+ */
+void UpdateMateSolve() {
+    pthread_mutex_lock(&solveMutex);
+    JobState state = solveState;
+    pthread_mutex_unlock(&solveMutex);
 
-        float scale = 50.0f / tex.width;
+    if (state != JOB_READY) return;
 
-        Vector2 pos = {
-            slot.x + (60 - tex.width*scale)/2,
-            slot.y + (60 - tex.height*scale)/2
-        };
+    pthread_join(solveThread, NULL);
+    solveHasResult = true;
+    solveState = JOB_IDLE;
+}
 
-        DrawTextureEx(tex, pos, 0, scale, WHITE);
+bool MateHintValid() {
+    return solveHasResult && zobristReady && HashPosition() == solveKey;
+}
 
-        if (CheckCollisionPointRec(GetMousePosition(), slot)
-            && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+/**
+ * @brief Highlights the key move of a proven mate on the board
+ */
+void DrawMateHint() {
+    if (!MateHintValid() || !solveResult.hasMove) return;
 
-            board[promotionRow][promotionCol].type = options[i];
+    Move m = solveResult.key;
+    DrawRectangle(m.sc * tileSize, m.sr * tileSize, tileSize, tileSize, Fade(SKYBLUE, 0.45f));
+    DrawRectangle(m.dc * tileSize, m.dr * tileSize, tileSize, tileSize, Fade(SKYBLUE, 0.45f));
+    DrawRectangleLines(m.dc * tileSize, m.dr * tileSize, tileSize, tileSize, SKYBLUE);
+}
 
-            promotionActive = false;
+/**
+ * @brief Sidebar line with the solver status
+ */
+void DrawMateStatus(int x, int y) {
+    const char* text = NULL;
+    Color color = SKYBLUE;
+
+    if (solveState != JOB_IDLE) {
+        text = "SOLVING...";
+    } else if (MateHintValid()) {
+        if (solveResult.mateIn > 0) {
+            text = TextFormat("MATE IN %d: %s", solveResult.mateIn, solveResult.keySan);
+        } else {
+            text = solveResult.aborted ? "NO MATE FOUND (BUDGET)"
+                                       : TextFormat("NO MATE IN %d", MATE_DEFAULT_MOVES);
+            color = LIGHTGRAY;
         }
-
     }
-}
\ No newline at end of file
+    if (text != NULL) DrawText(text, x, y, 14, color);
+}
+
+/**
+ * @brief Cancels a running solve and waits for the worker
+ */
+void StopMateSolve() {
+    if (solveState == JOB_IDLE) return;
+
+    solveCancel = true;
+    pthread_join(solveThread, NULL);
+    solveState = JOB_IDLE;
+}